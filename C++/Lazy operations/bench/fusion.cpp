@@ -0,0 +1,138 @@
+// Element-wise chains over 10M ints: containers::array, which materializes every intermediate, against the
+// fused lazy_wise_op evaluation. "eval" times eval() of an already built expression; "build + eval" includes
+// constructing the expression tree. Allocations and bytes are counted through a global operator new over one extra
+// call of each. Traffic is an estimate of the compulsory DRAM traffic: every eager operation reads two arrays and
+// writes one, the fused loop reads each distinct leaf once and writes the result once.
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include "../containers/od_con.h"
+#include "../containers/dd_con.h"
+
+#include "../lazy_containers/lazy_od_con.h"
+#include "../lazy_containers/lazy_dd_con.h"
+
+#include "../../exp/time_it.h"
+
+namespace
+{
+    std::atomic<size_t> heap_allocations{0};
+    std::atomic<size_t> heap_bytes{0};
+}
+
+void *operator new(std::size_t size)
+{
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    heap_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size ? size : 1))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+// Kept out of line: inlined next to the replaced operator new, GCC reports the free() as a mismatched deallocation.
+[[gnu::noinline]] void operator delete(void *ptr) noexcept { std::free(ptr); }
+[[gnu::noinline]] void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+namespace
+{
+    constexpr size_t size = 10000000;
+    constexpr double mb = 1024.0 * 1024.0;
+
+    struct allocations
+    {
+        size_t count = 0;
+        size_t bytes = 0;
+    };
+
+    template <typename Func>
+    allocations count_allocations(Func &&func)
+    {
+        const size_t count = heap_allocations.load();
+        const size_t bytes = heap_bytes.load();
+        func();
+        return {heap_allocations.load() - count, heap_bytes.load() - bytes};
+    }
+
+    void report(const char *label, const pot::utils::benchmark_result &result, const allocations &allocated,
+                double traffic)
+    {
+        std::printf("  %-14s %9.2f ms  %3zu allocs %8.1f MB  est. %6.2f GB/s", label, result.median / 1e6,
+                    allocated.count, static_cast<double>(allocated.bytes) / mb, traffic / result.median);
+        if (result.counters)
+        {
+            std::printf("  cache misses %12.0f", result.counters->cache_misses);
+        }
+        std::printf("\n");
+    }
+
+    template <typename Eager, typename Build>
+    void compare(const char *name, size_t operations, size_t leaves, Eager eager, Build build)
+    {
+        const pot::utils::benchmark_options options{.warm_up = 1, .samples = 10, .iterations = 1, .counters = true};
+        const double element = sizeof(int) * static_cast<double>(size);
+
+        auto run_eager = [&]
+        {
+            auto res = eager();
+            pot::utils::do_not_optimize(res);
+        };
+        const auto expression = build();
+        auto run_eval = [&]
+        {
+            auto res = expression.eval();
+            pot::utils::do_not_optimize(res);
+        };
+        auto run_build_eval = [&]
+        {
+            auto res = build().eval();
+            pot::utils::do_not_optimize(res);
+        };
+
+        const auto eager_result = pot::utils::benchmark(options, run_eager);
+        const auto eval_result = pot::utils::benchmark(options, run_eval);
+        const auto build_eval_result = pot::utils::benchmark(options, run_build_eval);
+
+        std::printf("%s\n", name);
+        report("array", eager_result, count_allocations(run_eager), 3 * element * static_cast<double>(operations));
+        report("lazy eval", eval_result, count_allocations(run_eval), element * static_cast<double>(leaves + 1));
+        report("build + eval", build_eval_result, count_allocations(run_build_eval),
+               element * static_cast<double>(leaves + 1));
+    }
+}
+
+int main()
+{
+    containers::array<int> a1(size);
+    containers::array<int> a2(size);
+
+    lazy_containers::lazy_array<int> la1(size);
+    lazy_containers::lazy_array<int> la2(size);
+
+    for (size_t i = 0; i < size; i++)
+    {
+        a1[i] = static_cast<int>(i);
+        a2[i] = static_cast<int>(i);
+
+        la1[i] = static_cast<int>(i);
+        la2[i] = static_cast<int>(i);
+    }
+
+    compare("a1 + a2", 1, 2, [&]
+            { return a1 + a2; }, [&]
+            { return la1 + la2; });
+
+    compare("a1 * a2 + a1", 2, 2, [&]
+            { return a1 * a2 + a1; }, [&]
+            { return la1 * la2 + la1; });
+
+    compare("a1 * a2 + a1 - a2 - a2 - a2", 5, 2, [&]
+            { return a1 * a2 + a1 - a2 - a2 - a2; }, [&]
+            { return la1 * la2 + la1 - la2 - la2 - la2; });
+
+    return 0;
+}
@@ -13,6 +13,7 @@ namespace lazy_containers
     protected:
         size_t m_rows, m_cols;
         std::vector<T> data;
+        lazy_operations::lifetime_token m_lifetime;
 
     public:
         using value_type = T;
@@ -54,6 +55,7 @@ namespace lazy_containers
 
         size_t rows() const { return m_rows; }
         size_t cols() const { return m_cols; }
+        const lazy_operations::lifetime_token &lifetime() const { return m_lifetime; }
     };
 
     template <typename T>
@@ -8,6 +8,7 @@ namespace lazy_containers
     {
     protected:
         std::vector<T> data;
+        lazy_operations::lifetime_token m_lifetime;
 
     public:
         using value_type = T;
@@ -16,6 +17,7 @@ namespace lazy_containers
         od_base(std::initializer_list<T> list) : data(list) {}
 
         std::size_t size() const { return data.size(); }
+        const lazy_operations::lifetime_token &lifetime() const { return m_lifetime; }
         T &operator[](std::size_t i) { return data[i]; }
         const T &operator[](std::size_t i) const { return data[i]; }
 
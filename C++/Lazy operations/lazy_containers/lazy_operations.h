@@ -3,40 +3,125 @@
 #include <cassert>
 #include <stddef.h>
 #include <functional>
+#include <memory>
+#include <type_traits>
 #include <vector>
 
 namespace lazy_operations
 {
+    // Base of every expression node. Nodes hold sub-expressions by value (they are small) and leaf containers
+    // by reference, so building an expression never copies element data.
+    struct expression
+    {
+    };
+
+    template <typename T>
+    inline constexpr bool is_expression_v = std::is_base_of_v<expression, T>;
+
+#ifndef NDEBUG
+    // Debug builds give every lazy leaf container a token that expires when the container is destroyed; nodes
+    // that refer to the leaf assert on it before each use, so an expression that outlived an operand fails loudly.
+    // A copy is a different object and gets its own token.
+    class lifetime_token
+    {
+    private:
+        std::shared_ptr<const bool> m_alive = std::make_shared<const bool>(true);
+
+    public:
+        lifetime_token() = default;
+        lifetime_token(const lifetime_token &) : lifetime_token() {}
+        lifetime_token &operator=(const lifetime_token &) { return *this; }
+
+        std::weak_ptr<const bool> watch() const { return m_alive; }
+    };
+#else
+    struct lifetime_token
+    {
+    };
+#endif
+
+    // Non-owning reference to a leaf operand.
+    template <typename T>
+    class leaf_ref
+    {
+    private:
+        const T *m_value;
+#ifndef NDEBUG
+        std::weak_ptr<const bool> m_alive;
+#endif
+
+    public:
+        leaf_ref(const T &value) : m_value(&value)
+        {
+#ifndef NDEBUG
+            if constexpr (requires { value.lifetime(); })
+                m_alive = value.lifetime().watch();
+#endif
+        }
+
+        const T &get() const
+        {
+#ifndef NDEBUG
+            if constexpr (requires(const T &value) { value.lifetime(); })
+                assert(!m_alive.expired() && "lazy expression used after one of its operands was destroyed");
+#endif
+            return *m_value;
+        }
+    };
+
+    template <typename T>
+    using stored_operand_t = std::conditional_t<is_expression_v<T>, T, leaf_ref<T>>;
+
+    template <typename T>
+    const T &operand(const T &value)
+    {
+        return value;
+    }
+
     template <typename T>
-    auto try_eval(const T &value)
+    const T &operand(const leaf_ref<T> &ref)
+    {
+        return ref.get();
+    }
+
+    // A leaf as is, a sub-expression evaluated into a container.
+    template <typename T>
+    decltype(auto) try_eval(const T &value)
     {
         if constexpr (requires { value.eval(); })
             return value.eval();
         else
-            return value;
+            return (value);
     }
 
+    // Operands are leaf containers or other lazy_wise_op nodes; both are indexable, so element i of the whole
+    // tree is computed straight from the leaves and eval() is one loop with no intermediate containers.
     template <typename Container, typename Op, typename LHS, typename RHS>
-    class lazy_wise_op
+    class lazy_wise_op : public expression
     {
     private:
-        const LHS m_lhs;
-        const RHS m_rhs;
+        const stored_operand_t<LHS> m_lhs;
+        const stored_operand_t<RHS> m_rhs;
         Op m_op;
 
     public:
         lazy_wise_op(const LHS &lhs, const RHS &rhs, Op op)
-            : m_lhs(lhs), m_rhs(rhs), m_op(op) {}
+            : m_lhs(lhs), m_rhs(rhs), m_op(op)
+        {
+            assert(operand(m_lhs).size() == operand(m_rhs).size());
+        }
+
+        size_t size() const { return operand(m_lhs).size(); }
+
+        auto operator[](size_t i) const { return m_op(operand(m_lhs)[i], operand(m_rhs)[i]); }
 
         Container eval() const
         {
-            auto lhs_eval = try_eval(m_lhs);
-            auto rhs_eval = try_eval(m_rhs);
-            assert(lhs_eval.size() == rhs_eval.size());
-            Container result(lhs_eval.size());
-            for (size_t i = 0; i < lhs_eval.size(); ++i)
+            const size_t n = size();
+            Container result(n);
+            for (size_t i = 0; i < n; ++i)
             {
-                result[i] = m_op(lhs_eval[i], rhs_eval[i]);
+                result[i] = (*this)[i];
             }
             return result;
         }
@@ -60,17 +145,17 @@ namespace lazy_operations
         template <typename Other>
         auto operator*(const Other &other) const
         {
-            return lazy_wise_op<Container, std::minus<typename Container::value_type>,
+            return lazy_wise_op<Container, std::multiplies<typename Container::value_type>,
                                 lazy_wise_op, Other>(*this, other, std::multiplies<typename Container::value_type>());
         }
     };
 
     template <typename T, typename LHS, typename RHS>
-    class lazy_dot
+    class lazy_dot : public expression
     {
     private:
-        const LHS m_lhs;
-        const RHS m_rhs;
+        const stored_operand_t<LHS> m_lhs;
+        const stored_operand_t<RHS> m_rhs;
 
     public:
         lazy_dot(const LHS &lhs, const RHS &rhs)
@@ -78,13 +163,13 @@ namespace lazy_operations
 
         T eval() const
         {
-            auto lhs_eval = try_eval(m_lhs);
-            auto rhs_eval = try_eval(m_rhs);
-            assert(lhs_eval.size() == rhs_eval.size());
+            const auto &lhs = operand(m_lhs);
+            const auto &rhs = operand(m_rhs);
+            assert(lhs.size() == rhs.size());
             T result = 0;
-            for (size_t i = 0; i < lhs_eval.size(); ++i)
+            for (size_t i = 0; i < lhs.size(); ++i)
             {
-                result += lhs_eval[i] * rhs_eval[i];
+                result += lhs[i] * rhs[i];
             }
             return result;
         }
@@ -93,11 +178,11 @@ namespace lazy_operations
     };
 
     template <typename Container, typename Op, typename LHS, typename RHS>
-    class lazy_wise_op2d
+    class lazy_wise_op2d : public expression
     {
     private:
-        const LHS m_lhs;
-        const RHS m_rhs;
+        const stored_operand_t<LHS> m_lhs;
+        const stored_operand_t<RHS> m_rhs;
         Op m_op;
 
     public:
@@ -106,8 +191,8 @@ namespace lazy_operations
 
         Container eval() const
         {
-            auto lhs_eval = try_eval(m_lhs);
-            auto rhs_eval = try_eval(m_rhs);
+            decltype(auto) lhs_eval = try_eval(operand(m_lhs));
+            decltype(auto) rhs_eval = try_eval(operand(m_rhs));
             assert(lhs_eval.rows() == rhs_eval.rows() && lhs_eval.cols() == rhs_eval.cols());
             Container result(lhs_eval.rows(), lhs_eval.cols());
             for (size_t i = 0; i < lhs_eval.rows(); ++i)
@@ -145,11 +230,11 @@ namespace lazy_operations
     };
 
     template <typename T, typename LHS, typename RHS>
-    class lazy_matrix_mult
+    class lazy_matrix_mult : public expression
     {
     private:
-        const LHS m_lhs;
-        const RHS m_rhs;
+        const stored_operand_t<LHS> m_lhs;
+        const stored_operand_t<RHS> m_rhs;
 
     public:
         lazy_matrix_mult(const LHS &lhs, const RHS &rhs)
@@ -157,8 +242,8 @@ namespace lazy_operations
 
         containers::matrix<T> eval() const
         {
-            auto lhs_eval = try_eval(m_lhs);
-            auto rhs_eval = try_eval(m_rhs);
+            decltype(auto) lhs_eval = try_eval(operand(m_lhs));
+            decltype(auto) rhs_eval = try_eval(operand(m_rhs));
             assert(lhs_eval.cols() == rhs_eval.rows());
             containers::matrix<T> result(lhs_eval.rows(), rhs_eval.cols());
             for (size_t i = 0; i < lhs_eval.rows(); ++i)
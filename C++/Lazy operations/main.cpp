@@ -8,38 +8,7 @@
 #include "./lazy_containers/lazy_od_con.h"
 #include "./lazy_containers/lazy_dd_con.h"
 
-namespace utils
-{
-    template <typename DurationType, typename IterationCleanUpCallback, typename Func, typename... Args>
-    DurationType time_it(size_t n, IterationCleanUpCallback &&callback, Func &&func, Args &&...args)
-        requires std::invocable<Func, Args...> &&
-                 requires { { std::chrono::duration_cast<DurationType>(std::chrono::high_resolution_clock::now() - std::chrono::high_resolution_clock::now()) }; }
-    {
-        using clock_type = std::chrono::high_resolution_clock;
-
-        clock_type::duration duration{0};
-
-        for (size_t i = 0; i < n; i++)
-        {
-            const auto start = clock_type::now();
-            std::invoke(std::forward<Func>(func), std::forward<Args>(args)...);
-            const auto end = clock_type::now();
-            duration += end - start;
-
-            std::invoke(std::forward<IterationCleanUpCallback>(callback));
-        }
-
-        return std::chrono::duration_cast<DurationType>(duration / n);
-    }
-
-    template <typename DurationType, typename Func, typename... Args>
-    DurationType time_it(Func &&func, Args &&...args)
-        requires std::invocable<Func, Args...> &&
-                 requires { { std::chrono::duration_cast<DurationType>(std::chrono::high_resolution_clock::now() - std::chrono::high_resolution_clock::now()) }; }
-    {
-        return time_it<DurationType, Func, Args...>(1, {}, std::forward<Func>(func), std::forward<Args>(args)...);
-    }
-}
+#include "../exp/time_it.h"
 
 int main()
 {
@@ -122,18 +91,20 @@ int main()
         la2[i] = i;
     }
 
-    auto dur = utils::time_it<std::chrono::nanoseconds>(10, [] {}, [&]()
-                                                        { volatile auto res = a1 * a2 + a1 - a2 - a2 - a2; })
-                   .count();
+    const pot::utils::benchmark_options options{.warm_up = 1, .samples = 10, .iterations = 1, .counters = true};
+
+    const auto eager = pot::utils::benchmark(options, [&]()
+                                             { auto res = a1 * a2 + a1 - a2 - a2 - a2;
+                                               pot::utils::do_not_optimize(res); });
 
-    auto ldur = utils::time_it<std::chrono::nanoseconds>(10, [] {}, [&]()
-                                                         { auto t = la1 * la2 + la1 - la2 - la2 - la2;;
-                                                            volatile auto res = t.eval(); })
-                    .count();
+    const auto lazy = pot::utils::benchmark(options, [&]()
+                                            { auto t = la1 * la2 + la1 - la2 - la2 - la2;
+                                              auto res = t.eval();
+                                              pot::utils::do_not_optimize(res); });
 
-    std::cout << "Array: " << dur << " ns\n";
-    std::cout << "Lazy array: " << ldur << " ns\n";
-    std::cout << (double)ldur / dur << "\n";
+    pot::utils::print_result("Array", eager);
+    pot::utils::print_result("Lazy array", lazy);
+    std::printf("%f\n", lazy.median / eager.median);
 
     return 0;
 }
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include "schedule_point.h"
+
+#if defined(__linux__)
+#include <cerrno>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace pot::details
+{
+    // Futex-style wait on a 32-bit word. std::atomic::wait has no timed variant, so on Linux the
+    // futex is driven directly; waits and wakes must then both go through these helpers.
+
+    inline void atomic_wait(const std::atomic<uint32_t> &word, uint32_t expected) noexcept
+    {
+#if POT_DETERMINISTIC_SCHEDULING
+        if (deterministic_scheduler::active())
+        {
+            deterministic_scheduler::wait_on(&word, [&]
+                                             { return word.load(std::memory_order_acquire) == expected; });
+            return;
+        }
+#endif
+#if defined(__linux__)
+        while (word.load(std::memory_order_acquire) == expected)
+        {
+            syscall(SYS_futex, reinterpret_cast<const uint32_t *>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+        }
+#else
+        word.wait(expected, std::memory_order_acquire);
+#endif
+    }
+
+    // Returns false if the deadline passed while the word still held expected.
+    inline bool atomic_wait_until(const std::atomic<uint32_t> &word, uint32_t expected,
+                                  std::chrono::steady_clock::time_point deadline) noexcept
+    {
+#if POT_DETERMINISTIC_SCHEDULING
+        // Under the scheduler the deadline is taken to pass at the next switch.
+        if (deterministic_scheduler::active())
+        {
+            deterministic_scheduler::yield();
+            return word.load(std::memory_order_acquire) != expected;
+        }
+#endif
+#if defined(__linux__)
+        while (word.load(std::memory_order_acquire) == expected)
+        {
+            const auto since_epoch = deadline.time_since_epoch();
+            if (since_epoch <= std::chrono::steady_clock::now().time_since_epoch())
+            {
+                return false;
+            }
+
+            // FUTEX_WAIT_BITSET takes an absolute CLOCK_MONOTONIC timeout, which is what steady_clock reads on Linux.
+            const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(since_epoch);
+            const timespec timeout{static_cast<time_t>(seconds.count()),
+                                   static_cast<long>(std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch - seconds).count())};
+            syscall(SYS_futex, reinterpret_cast<const uint32_t *>(&word), FUTEX_WAIT_BITSET_PRIVATE, expected, &timeout,
+                    nullptr, FUTEX_BITSET_MATCH_ANY);
+        }
+        return true;
+#else
+        auto pause = std::chrono::microseconds(1);
+        while (word.load(std::memory_order_acquire) == expected)
+        {
+            const auto now = std::chrono::steady_clock::now();
+            if (now >= deadline)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(pause, deadline - now));
+            pause = std::min(pause * 2, std::chrono::microseconds(1000));
+        }
+        return true;
+#endif
+    }
+
+    inline void atomic_notify_all(std::atomic<uint32_t> &word) noexcept
+    {
+#if POT_DETERMINISTIC_SCHEDULING
+        if (deterministic_scheduler::active())
+        {
+            deterministic_scheduler::notify_all(&word);
+            return;
+        }
+#endif
+#if defined(__linux__)
+        syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE_PRIVATE, INT32_MAX, nullptr, nullptr, 0);
+#else
+        word.notify_all();
+#endif
+    }
+}
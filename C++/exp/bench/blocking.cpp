@@ -0,0 +1,74 @@
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "../blocking_executor.h"
+#include "../thread_pool_executor.h"
+#include "../when_all.h"
+
+namespace
+{
+    using clock_type = std::chrono::steady_clock;
+
+    constexpr size_t requests = 256;
+    constexpr auto io_time = std::chrono::milliseconds(5);
+    constexpr auto compute_time = std::chrono::microseconds(200);
+
+    void burn(std::chrono::microseconds duration)
+    {
+        const auto until = clock_type::now() + duration;
+        while (clock_type::now() < until)
+        {
+        }
+    }
+
+    // Stands in for a read that waits on a disk or a socket.
+    int blocking_read()
+    {
+        std::this_thread::sleep_for(io_time);
+        return 1;
+    }
+
+    pot::coroutines::task<int> inline_request()
+    {
+        const int bytes = blocking_read();
+        burn(compute_time);
+        co_return bytes;
+    }
+
+    pot::coroutines::task<int> offloaded_request()
+    {
+        const int bytes = co_await pot::offload_blocking(blocking_read);
+        burn(compute_time);
+        co_return bytes;
+    }
+
+    template <typename Request>
+    void bench(const char *label, pot::executor &executor, Request request)
+    {
+        const auto start = clock_type::now();
+        std::vector<pot::coroutines::task<int>> tasks;
+        tasks.reserve(requests);
+        for (size_t i = 0; i < requests; ++i)
+        {
+            tasks.push_back(executor.run(request));
+        }
+        pot::when_all(std::move(tasks)).get();
+        const double elapsed = std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+        std::printf("%-28s %zu requests (%lld ms I/O + %lld us compute) on %zu compute threads: %8.1f ms\n", label,
+                    requests, static_cast<long long>(io_time.count()), static_cast<long long>(compute_time.count()),
+                    executor.thread_count(), elapsed);
+    }
+}
+
+int main()
+{
+    pot::executors::thread_pool_executor_lq compute("Compute", std::thread::hardware_concurrency());
+
+    bench("blocking on compute workers", compute, inline_request);
+    bench("offload_blocking", compute, offloaded_request);
+    std::printf("blocking executor peaked at %zu threads\n", pot::default_blocking_executor().peak_thread_count());
+
+    return 0;
+}
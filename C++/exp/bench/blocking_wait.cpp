@@ -0,0 +1,63 @@
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <thread>
+#include <vector>
+
+#include "../thread_pool_executor.h"
+
+namespace
+{
+    int spin_work(size_t iterations)
+    {
+        volatile size_t sink = 0;
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            sink = sink + i;
+        }
+        return static_cast<int>(sink & 1);
+    }
+
+    // waiters external threads each submit a task and block in task::get() until a pool worker produced it.
+    // Waiters that burn CPU while blocked steal it from the producers, which shows up in both columns.
+    template <typename Executor>
+    void bench_waiters(const char *label, size_t producers, size_t waiters, size_t rounds, size_t work)
+    {
+        Executor executor("Main", producers);
+
+        const auto cpu_start = std::clock();
+        const auto wall_start = std::chrono::steady_clock::now();
+        {
+            std::vector<std::jthread> threads;
+            for (size_t w = 0; w < waiters; ++w)
+            {
+                threads.emplace_back([&]
+                                     {
+                    for (size_t r = 0; r < rounds; ++r)
+                    {
+                        auto task = executor.run([work]() -> pot::coroutines::task<int>
+                                                 { co_return spin_work(work); });
+                        task.get();
+                    } });
+            }
+        }
+        const auto wall = std::chrono::steady_clock::now() - wall_start;
+        const double cpu_seconds = static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+
+        std::printf("%-10s producers=%-3zu waiters=%-3zu wall=%8.1f ms  cpu=%8.1f ms\n", label, producers, waiters,
+                    std::chrono::duration<double, std::milli>(wall).count(), cpu_seconds * 1000.0);
+    }
+}
+
+int main()
+{
+    const size_t cores = std::max<size_t>(1, std::thread::hardware_concurrency());
+
+    for (size_t waiters : {cores, 4 * cores})
+    {
+        bench_waiters<pot::executors::thread_pool_executor_gq>("gq", cores, waiters, 200, 200000);
+        bench_waiters<pot::executors::thread_pool_executor_lq>("lq", cores, waiters, 200, 200000);
+    }
+
+    return 0;
+}
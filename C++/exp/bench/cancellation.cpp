@@ -0,0 +1,242 @@
+// Checks the cancellation paths of run, run_detached, parfor and when_all. The manual_executor cases are
+// deterministic: jobs only run when driven, so a stop can be requested exactly between two of them. The pool cases
+// then cancel from another thread while work is in flight. Exits non-zero on the first failed check.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+#include "../channel.h"
+#include "../manual_executor.h"
+#include "../parfor.h"
+#include "../thread_pool_executor.h"
+#include "../time_it.h"
+#include "../when_all.h"
+
+namespace
+{
+    void expect(bool condition, const char *what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAILED: %s\n", what);
+            std::exit(1);
+        }
+    }
+
+    template <typename Func>
+    bool throws_cancelled(Func &&func)
+    {
+        try
+        {
+            func();
+        }
+        catch (const pot::operation_cancelled &)
+        {
+            return true;
+        }
+        return false;
+    }
+
+    // Jobs still queued when the stop is requested never run; their awaiters get operation_cancelled.
+    void queued_jobs_are_dropped()
+    {
+        pot::executors::manual_executor executor;
+        std::stop_source source;
+        int ran = 0;
+
+        executor.run_detached(source.get_token(), [&]
+                              { ++ran; });
+        auto future = executor.run(source.get_token(), [&]
+                                   { return ++ran; });
+        auto task = executor.run(source.get_token(), [&]() -> pot::coroutines::task<int>
+                                 { co_return ++ran; });
+        auto kept = executor.run([&]
+                                 { return ++ran; });
+
+        source.request_stop();
+        executor.drain();
+
+        expect(ran == 1, "only the job without a token ran");
+        expect(kept.get() == 1, "a job without a token is unaffected");
+        expect(throws_cancelled([&]
+                                { future.get(); }),
+               "run(token, f) future throws operation_cancelled");
+        expect(throws_cancelled([&]
+                                { task.get(); }),
+               "awaiting a cancelled run(token, coroutine) throws operation_cancelled");
+    }
+
+    // A stop after some chunks ran: the rest are skipped and the parfor task fails.
+    void parfor_stops_between_chunks()
+    {
+        constexpr int chunks = 8;
+
+        {
+            pot::executors::manual_executor executor;
+            std::stop_source source;
+            int ran = 0;
+            auto loop = pot::algorithms::parfor<1>(executor, 0, chunks, [&](int)
+                                                   { ++ran; }, source.get_token());
+            loop.start();
+            executor.run_one();
+            executor.run_one();
+            source.request_stop();
+            executor.drain();
+            expect(ran == 2, "parfor runs no chunk after the stop");
+            expect(throws_cancelled([&]
+                                    { loop.get(); }),
+                   "cancelled parfor throws operation_cancelled");
+        }
+
+        {
+            pot::executors::manual_executor executor;
+            std::stop_source source;
+            int ran = 0;
+            auto loop = pot::algorithms::parfor<1>(executor, 0, chunks, [&](int) -> pot::coroutines::task<void>
+                                                   { ++ran; co_return; }, source.get_token());
+            loop.start();
+            executor.run_one();
+            source.request_stop();
+            executor.drain();
+            expect(ran < chunks, "coroutine parfor skips chunks after the stop");
+            expect(throws_cancelled([&]
+                                    { loop.get(); }),
+                   "cancelled coroutine parfor throws operation_cancelled");
+        }
+    }
+
+    pot::coroutines::task<int> wait_forever(pot::channel<int> &never)
+    {
+        auto next = never.recv();
+        co_return (co_await next).value_or(-1);
+    }
+
+    pot::coroutines::task<void> join_with_straggler(pot::executor &executor, pot::channel<int> &never,
+                                                    std::stop_token token, bool &cancelled,
+                                                    pot::executor *&resumed_on)
+    {
+        auto to_executor = executor.schedule();
+        co_await to_executor;
+
+        std::vector<pot::coroutines::task<int>> tasks;
+        tasks.push_back(executor.run(token, []() -> pot::coroutines::task<int>
+                                     { co_return 1; }));
+        tasks.push_back(executor.run(token, wait_forever, std::ref(never)));
+        try
+        {
+            auto all = pot::when_all(std::move(tasks), token);
+            co_await all;
+        }
+        catch (const pot::operation_cancelled &)
+        {
+            cancelled = true;
+            resumed_on = pot::executor::current();
+        }
+    }
+
+    // The join gives up on a child that never finishes, and resumes on its own executor rather than on the
+    // thread that requested the stop.
+    void when_all_short_circuits()
+    {
+        pot::executors::manual_executor executor;
+        pot::channel<int> never(1);
+        std::stop_source source;
+        bool cancelled = false;
+        pot::executor *resumed_on = nullptr;
+
+        auto join = join_with_straggler(executor, never, source.get_token(), cancelled, resumed_on);
+        join.start();
+        executor.drain();
+        expect(!join.await_ready(), "when_all waits for the blocked child");
+
+        source.request_stop();
+        expect(!cancelled, "the stop callback does not resume the awaiter inline");
+        executor.drain();
+        expect(cancelled, "when_all throws operation_cancelled without waiting for the blocked child");
+        expect(resumed_on == &executor, "the cancelled awaiter resumes on its executor");
+        join.get();
+
+        // The straggler still finishes (and frees its frame) once it can.
+        never.close();
+        executor.drain();
+    }
+
+    void when_all_already_cancelled()
+    {
+        pot::executors::manual_executor executor;
+        std::stop_source source;
+        source.request_stop();
+        int ran = 0;
+
+        std::vector<pot::coroutines::task<void>> tasks;
+        for (int i = 0; i < 4; ++i)
+        {
+            tasks.push_back([](int &ran) -> pot::coroutines::task<void>
+                            { ++ran; co_return; }(ran));
+        }
+        auto all = pot::when_all(std::move(tasks), source.get_token());
+        expect(throws_cancelled([&]
+                                { all.get(); }),
+               "when_all on a cancelled token throws");
+        executor.drain();
+        expect(ran == 0, "when_all does not start tasks once cancelled");
+    }
+
+    // Cancels from another thread while chunks run on the pool: every round either finishes or fails with
+    // operation_cancelled, and none hangs.
+    template <typename Executor>
+    void stop_under_contention(const char *label, size_t threads)
+    {
+        Executor executor("Cancel", threads);
+        size_t completed = 0;
+        size_t cancelled = 0;
+        for (int round = 0; round < 200; ++round)
+        {
+            std::stop_source source;
+            std::atomic<int> ran{0};
+            auto loop = pot::algorithms::parfor<64>(executor, 0, 64 * 64, [&](int)
+                                                    {
+                for (int spin = 0; spin < 200; ++spin)
+                {
+                    pot::utils::do_not_optimize(spin);
+                }
+                ran.fetch_add(1, std::memory_order_relaxed); }, source.get_token());
+            std::jthread stopper([&source, round]
+                                 {
+                std::this_thread::sleep_for(std::chrono::microseconds(round % 50));
+                source.request_stop(); });
+            if (throws_cancelled([&]
+                                 { loop.get(); }))
+            {
+                ++cancelled;
+            }
+            else
+            {
+                expect(ran.load() == 64 * 64, "an uncancelled parfor runs every index");
+                ++completed;
+            }
+        }
+        std::printf("%-4s threads=%zu: %zu rounds completed, %zu cancelled\n", label, threads, completed, cancelled);
+    }
+}
+
+int main()
+{
+    queued_jobs_are_dropped();
+    parfor_stops_between_chunks();
+    when_all_short_circuits();
+    when_all_already_cancelled();
+    std::printf("manual_executor checks passed\n");
+
+    const size_t threads = std::max<size_t>(2, std::thread::hardware_concurrency());
+    stop_under_contention<pot::executors::thread_pool_executor_gq>("gq", threads);
+    stop_under_contention<pot::executors::thread_pool_executor_lq>("lq", threads);
+
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "../inline_executor.h"
+#include "../manual_executor.h"
+#include "../thread_pool_executor.h"
+#include "../time_it.h"
+
+namespace
+{
+    constexpr size_t jobs = 100'000;
+
+    volatile long sink;
+
+    pot::coroutines::task<int> leaf(int x)
+    {
+        co_return x + 1;
+    }
+
+    // Submits `jobs` tasks, lets the executor run them and collects the results; per-job cost in nanoseconds.
+    template <typename Drive>
+    double spawn_and_join(pot::executor &executor, Drive drive)
+    {
+        std::vector<pot::coroutines::task<int>> tasks;
+        tasks.reserve(jobs);
+        const auto duration = pot::utils::time_it<std::chrono::nanoseconds>(5, [&]
+                                                                            { tasks.clear(); }, [&]
+                                                                            {
+            for (size_t i = 0; i < jobs; ++i)
+            {
+                tasks.push_back(executor.run(leaf, static_cast<int>(i)));
+            }
+            drive();
+            for (auto &task : tasks)
+            {
+                sink = task.get();
+            } });
+        return static_cast<double>(duration.count()) / jobs;
+    }
+
+    void report(const char *label, double ns)
+    {
+        std::printf("%-28s %8.1f ns/task\n", label, ns);
+    }
+}
+
+int main()
+{
+    // Framework cost alone: no threads to wake, no queues to contend on.
+    pot::executors::inline_executor inline_executor;
+    report("inline_executor", spawn_and_join(inline_executor, [] {}));
+
+    pot::executors::manual_executor manual;
+    report("manual_executor (drain)", spawn_and_join(manual, [&]
+                                                     { manual.drain(); }));
+
+    // The same work with real workers: the difference is hand-off and wake-up cost.
+    pot::executors::thread_pool_executor_gq gq("Global queue", 4);
+    report("thread_pool_executor_gq (4)", spawn_and_join(gq, [] {}));
+
+    pot::executors::thread_pool_executor_lq lq("Local queues", 4);
+    report("thread_pool_executor_lq (4)", spawn_and_join(lq, [] {}));
+
+    return 0;
+}
@@ -0,0 +1,292 @@
+// Executor microbenchmarks: spawn throughput, when_all fan-out/fan-in, ping-pong latency between two pools and
+// parfor over a memory-bound kernel, for thread_pool_executor_gq and _lq at 1, 2, 4, ... threads and at N.
+//
+//     executor_suite [--max-threads N] [--samples S] [--json FILE]
+//
+// Every case repeats its measurement S times after a warm-up and reports p50 and p99 of the per-operation cost
+// (lower is better throughout).
+// --json writes the same rows as a flat array, one object per line, so two runs diff cleanly.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <latch>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../parfor.h"
+#include "../thread_pool_executor.h"
+#include "../time_it.h"
+#include "../when_all.h"
+
+namespace
+{
+    using clock_type = std::chrono::steady_clock;
+
+    struct options
+    {
+        size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+        size_t samples = 30;
+        const char *json = nullptr;
+    };
+
+    struct row
+    {
+        std::string benchmark;
+        std::string executor;
+        size_t threads;
+        const char *unit;
+        size_t samples;
+        double p50;
+        double p99;
+        double mean;
+        double min;
+    };
+
+    row summarize(std::string benchmark, std::string executor, size_t threads, const char *unit,
+                  std::vector<double> values)
+    {
+        const auto stats = pot::utils::summarize(std::move(values));
+        return {std::move(benchmark), std::move(executor), threads, unit, stats.samples, stats.median, stats.p99,
+                stats.mean, stats.min};
+    }
+
+    // Calls `sample` for a warm-up, then `count` more times; each call returns one per-operation measurement.
+    template <typename Sample>
+    row measure(std::string benchmark, std::string executor, size_t threads, const char *unit, size_t count,
+                Sample sample)
+    {
+        const size_t warm_up = std::max<size_t>(2, count / 10);
+        for (size_t i = 0; i < warm_up; ++i)
+        {
+            sample();
+        }
+
+        std::vector<double> values;
+        values.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            values.push_back(sample());
+        }
+        return summarize(std::move(benchmark), std::move(executor), threads, unit, std::move(values));
+    }
+
+    double elapsed_ns(clock_type::time_point start)
+    {
+        return std::chrono::duration<double, std::nano>(clock_type::now() - start).count();
+    }
+
+    // Empty jobs through run_detached, joined with a latch.
+    template <typename Executor>
+    row spawn(const char *name, size_t threads, const options &opts)
+    {
+        constexpr size_t jobs = 20'000;
+        Executor executor("Suite", threads);
+        return measure("spawn", name, threads, "ns/task", opts.samples, [&]
+                       {
+            std::latch done(static_cast<ptrdiff_t>(jobs));
+            const auto start = clock_type::now();
+            for (size_t i = 0; i < jobs; ++i)
+            {
+                executor.run_detached([&done]
+                                      { done.count_down(); });
+            }
+            done.wait();
+            return elapsed_ns(start) / jobs; });
+    }
+
+    pot::coroutines::task<int> leaf(int x)
+    {
+        co_return x;
+    }
+
+    pot::coroutines::task<long> fan_out(pot::executor &executor, size_t width)
+    {
+        std::vector<pot::coroutines::task<int>> tasks;
+        tasks.reserve(width);
+        for (size_t i = 0; i < width; ++i)
+        {
+            tasks.push_back(executor.run(leaf, static_cast<int>(i)));
+        }
+        auto all = pot::when_all(std::move(tasks));
+        const auto results = co_await all;
+        long sum = 0;
+        for (int value : results)
+        {
+            sum += value;
+        }
+        co_return sum;
+    }
+
+    // One round: `width` child tasks started and joined with when_all.
+    template <typename Executor>
+    row fan_out_in(const char *name, size_t threads, const options &opts)
+    {
+        constexpr size_t width = 1'000;
+        Executor executor("Suite", threads);
+        return measure("fan_out_in", name, threads, "us/round", opts.samples, [&]
+                       {
+            const auto start = clock_type::now();
+            const long sum = fan_out(executor, width).get();
+            const double us = elapsed_ns(start) / 1000.0;
+            if (sum != static_cast<long>(width * (width - 1) / 2))
+            {
+                std::fprintf(stderr, "fan_out_in: wrong sum %ld\n", sum);
+                std::exit(1);
+            }
+            return us; });
+    }
+
+    // A coroutine hopping a -> b -> a; every round trip is one sample, so the percentiles are per hop pair.
+    pot::coroutines::task<void> ping_pong(pot::executor &a, pot::executor &b, std::vector<double> &round_trips)
+    {
+        auto to_a = pot::schedule_on(a);
+        co_await to_a;
+        for (size_t i = 0; i < round_trips.size(); ++i)
+        {
+            const auto start = clock_type::now();
+            auto there = pot::schedule_on(b);
+            co_await there;
+            auto back = pot::schedule_on(a);
+            co_await back;
+            round_trips[i] = elapsed_ns(start);
+        }
+    }
+
+    // Every round trip is its own sample, so p99 sees the individual slow hops.
+    template <typename Executor>
+    row ping_pong_latency(const char *name, size_t threads, const options &opts)
+    {
+        constexpr size_t round_trips_per_run = 200;
+        Executor a("Ping", threads);
+        Executor b("Pong", threads);
+
+        std::vector<double> warm_up(round_trips_per_run);
+        ping_pong(a, b, warm_up).get();
+
+        std::vector<double> round_trips(opts.samples * round_trips_per_run);
+        ping_pong(a, b, round_trips).get();
+
+        // The last hop's sender may still be inside the other pool's submit: join both before destroying either.
+        a.shutdown();
+        b.shutdown();
+        return summarize("ping_pong", name, threads, "ns/round_trip", std::move(round_trips));
+    }
+
+    // STREAM triad over 96 MB, far larger than the last-level cache.
+    template <typename Executor>
+    row parfor_triad(const char *name, size_t threads, const options &opts)
+    {
+        constexpr size_t n = size_t(1) << 22;
+        Executor executor("Suite", threads);
+        std::vector<double> a(n), b(n, 1.0), c(n, 2.0);
+        const double scalar = 3.0;
+        return measure("parfor_triad", name, threads, "ms/sweep", opts.samples, [&]
+                       {
+            const auto start = clock_type::now();
+            pot::algorithms::parfor(executor, size_t(0), n, [&](size_t i)
+                                    { a[i] = b[i] + scalar * c[i]; })
+                .get();
+            return elapsed_ns(start) / 1e6; });
+    }
+
+    template <typename Executor>
+    void run_all(const char *name, const options &opts, std::vector<row> &rows)
+    {
+        std::vector<size_t> sweep;
+        for (size_t threads = 1; threads < opts.max_threads; threads *= 2)
+        {
+            sweep.push_back(threads);
+        }
+        sweep.push_back(opts.max_threads);
+
+        for (size_t threads : sweep)
+        {
+            rows.push_back(spawn<Executor>(name, threads, opts));
+            rows.push_back(fan_out_in<Executor>(name, threads, opts));
+            rows.push_back(ping_pong_latency<Executor>(name, threads, opts));
+            rows.push_back(parfor_triad<Executor>(name, threads, opts));
+        }
+    }
+
+    void print(const std::vector<row> &rows)
+    {
+        std::printf("%-14s %-4s %7s %12s %12s %12s %12s  %s\n", "benchmark", "exec", "threads", "p50", "p99", "mean",
+                    "min", "unit");
+        for (const auto &r : rows)
+        {
+            std::printf("%-14s %-4s %7zu %12.1f %12.1f %12.1f %12.1f  %s\n", r.benchmark.c_str(), r.executor.c_str(),
+                        r.threads, r.p50, r.p99, r.mean, r.min, r.unit);
+        }
+    }
+
+    bool write_json(const char *path, const std::vector<row> &rows)
+    {
+        FILE *file = std::fopen(path, "w");
+        if (!file)
+        {
+            return false;
+        }
+        std::fprintf(file, "[\n");
+        for (size_t i = 0; i < rows.size(); ++i)
+        {
+            const auto &r = rows[i];
+            std::fprintf(file,
+                         "  {\"benchmark\": \"%s\", \"executor\": \"%s\", \"threads\": %zu, \"unit\": \"%s\", "
+                         "\"samples\": %zu, \"p50\": %.3f, \"p99\": %.3f, \"mean\": %.3f, \"min\": %.3f}%s\n",
+                         r.benchmark.c_str(), r.executor.c_str(), r.threads, r.unit, r.samples, r.p50, r.p99, r.mean,
+                         r.min, i + 1 < rows.size() ? "," : "");
+        }
+        std::fprintf(file, "]\n");
+        return std::fclose(file) == 0;
+    }
+
+    int usage(const char *program)
+    {
+        std::fprintf(stderr, "usage: %s [--max-threads N] [--samples S] [--json FILE]\n", program);
+        return 2;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    options opts;
+    for (int i = 1; i < argc; i += 2)
+    {
+        if (i + 1 == argc)
+        {
+            return usage(argv[0]);
+        }
+        if (std::strcmp(argv[i], "--max-threads") == 0)
+        {
+            opts.max_threads = std::max<size_t>(1, std::strtoull(argv[i + 1], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--samples") == 0)
+        {
+            opts.samples = std::max<size_t>(1, std::strtoull(argv[i + 1], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--json") == 0)
+        {
+            opts.json = argv[i + 1];
+        }
+        else
+        {
+            return usage(argv[0]);
+        }
+    }
+
+    std::vector<row> rows;
+    run_all<pot::executors::thread_pool_executor_gq>("gq", opts, rows);
+    run_all<pot::executors::thread_pool_executor_lq>("lq", opts, rows);
+
+    print(rows);
+    if (opts.json && !write_json(opts.json, rows))
+    {
+        std::fprintf(stderr, "cannot write %s\n", opts.json);
+        return 1;
+    }
+    return 0;
+}
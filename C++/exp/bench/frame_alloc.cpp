@@ -0,0 +1,102 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <memory_resource>
+#include <new>
+
+#include "../task_coroutine.h"
+#include "../time_it.h"
+
+namespace
+{
+    std::atomic<size_t> heap_allocations{0};
+}
+
+void *operator new(std::size_t size)
+{
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size ? size : 1))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+namespace
+{
+    constexpr size_t outer = 100;
+    constexpr size_t inner = 100;
+
+    // The shape of main.cpp's nested_loops_test, run inline: outer * inner short-lived child tasks.
+    pot::coroutines::task<int> leaf(int x)
+    {
+        co_return 42 * x;
+    }
+
+    template <typename Alloc>
+    pot::coroutines::task<int> leaf(std::allocator_arg_t, Alloc, int x)
+    {
+        co_return 42 * x;
+    }
+
+    pot::coroutines::task<int> nested_pooled()
+    {
+        int sum = 0;
+        for (size_t i = 0; i < outer; ++i)
+        {
+            for (size_t j = 0; j < inner; ++j)
+            {
+                sum += co_await leaf(static_cast<int>(i + j));
+            }
+        }
+        co_return sum;
+    }
+
+    template <typename Alloc>
+    pot::coroutines::task<int> nested_with(Alloc alloc)
+    {
+        int sum = 0;
+        for (size_t i = 0; i < outer; ++i)
+        {
+            for (size_t j = 0; j < inner; ++j)
+            {
+                sum += co_await leaf(std::allocator_arg, alloc, static_cast<int>(i + j));
+            }
+        }
+        co_return sum;
+    }
+
+    template <typename Make>
+    void bench(const char *label, Make make)
+    {
+        make().get();
+
+        const size_t before = heap_allocations.load();
+        const auto duration = pot::utils::time_it<std::chrono::nanoseconds>(20, [] {}, [&]
+                                                                            { make().get(); });
+        const double allocations = static_cast<double>(heap_allocations.load() - before) / (20.0 * outer * inner);
+        std::printf("%-28s %8.1f ns/task  %6.3f heap allocations/task\n", label,
+                    static_cast<double>(duration.count()) / (outer * inner), allocations);
+    }
+}
+
+int main()
+{
+    bench("global heap (std::allocator)", []
+          { return nested_with(std::allocator<std::byte>{}); });
+    bench("pooled frames (default)", []
+          { return nested_pooled(); });
+
+    std::pmr::monotonic_buffer_resource arena(1 << 20);
+    bench("pmr monotonic arena", [&]
+          {
+        arena.release();
+        return nested_with(std::pmr::polymorphic_allocator<std::byte>(&arena)); });
+
+    return 0;
+}
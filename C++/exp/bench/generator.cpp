@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "../generator.h"
+#include "../thread_pool_executor.h"
+#include "../time_it.h"
+
+namespace
+{
+    constexpr size_t records = 4'000'000;
+    constexpr size_t block = 4096;
+
+    struct record
+    {
+        size_t id;
+        double x;
+        double y;
+    };
+
+    record make_record(size_t i)
+    {
+        return {i, static_cast<double>(i % 1000) * 1e-3, 0.0};
+    }
+
+    // Buffered: every stage materialises the whole sequence, as erf(vector) style helpers do.
+    double buffered()
+    {
+        std::vector<record> source;
+        source.reserve(records);
+        for (size_t i = 0; i < records; ++i)
+        {
+            source.push_back(make_record(i));
+        }
+        std::vector<record> mapped;
+        mapped.reserve(records);
+        for (const auto &r : source)
+        {
+            mapped.push_back({r.id, r.x, std::erf(r.x)});
+        }
+        double sum = 0;
+        for (const auto &r : mapped)
+        {
+            sum += r.y;
+        }
+        return sum;
+    }
+
+    pot::coroutines::generator<record &> produce()
+    {
+        for (size_t i = 0; i < records; ++i)
+        {
+            record r = make_record(i);
+            co_yield r;
+        }
+    }
+
+    pot::coroutines::generator<const record &> map_erf(pot::coroutines::generator<record &> source)
+    {
+        for (record &r : source)
+        {
+            r.y = std::erf(r.x);
+            co_yield r;
+        }
+    }
+
+    double streamed()
+    {
+        double sum = 0;
+        for (const record &r : map_erf(produce()))
+        {
+            sum += r.y;
+        }
+        return sum;
+    }
+
+    pot::coroutines::task<std::vector<record>> fill_block(size_t first)
+    {
+        std::vector<record> out;
+        out.reserve(block);
+        for (size_t i = first; i < std::min(first + block, records); ++i)
+        {
+            record r = make_record(i);
+            r.y = std::erf(r.x);
+            out.push_back(r);
+        }
+        co_return out;
+    }
+
+    // The producer computes each block on the pool and streams it out one record at a time.
+    pot::coroutines::async_generator<const record &> produce_async(pot::executor &executor)
+    {
+        for (size_t first = 0; first < records; first += block)
+        {
+            auto filled = executor.run(fill_block, first);
+            const auto chunk = co_await filled;
+            for (const auto &r : chunk)
+            {
+                co_yield r;
+            }
+        }
+    }
+
+    pot::coroutines::task<double> consume_async(pot::executor &executor)
+    {
+        double sum = 0;
+        auto source = produce_async(executor);
+        for (auto it = co_await source.begin(); it != source.end(); co_await ++it)
+        {
+            sum += (*it).y;
+        }
+        co_return sum;
+    }
+
+    template <typename Func>
+    void bench(const char *label, Func func)
+    {
+        double result = 0;
+        const auto duration = pot::utils::time_it<std::chrono::microseconds>(5, [] {}, [&]
+                                                                             { result = func(); });
+        std::printf("%-32s %8.2f ms  %6.2f ns/record  (sum %.3f)\n", label, duration.count() / 1000.0,
+                    duration.count() * 1000.0 / records, result);
+    }
+}
+
+int main()
+{
+    bench("buffered vectors", buffered);
+    bench("generator pipeline", streamed);
+
+    pot::executors::thread_pool_executor_lq executor("Producer", 2);
+    bench("async_generator (pool blocks)", [&]
+          { return consume_async(executor).get(); });
+
+    return 0;
+}
@@ -0,0 +1,132 @@
+// Exercises the worker metrics end to end: runs a known number of jobs (submitted from outside and from the
+// workers themselves) on gq and lq pools, checks the snapshot counters against that number and writes the
+// snapshots as a Chrome trace. Exits non-zero on the first failed check.
+//
+//     metrics [TRACE_FILE]    (default: metrics_trace.json)
+
+#define POT_ENABLE_METRICS 1
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <latch>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../chrome_trace.h"
+#include "../thread_pool_executor.h"
+
+namespace
+{
+    void expect(bool condition, const char *label, const char *what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAILED (%s): %s\n", label, what);
+            std::exit(1);
+        }
+    }
+
+    constexpr size_t outer_jobs = 4'000;
+    // Every outer job submits this many more from its worker, so lq pools see local pushes and steals too.
+    constexpr size_t inner_jobs = 2;
+    constexpr size_t rounds = 3;
+
+    template <typename Executor>
+    void run(const char *label, size_t threads, std::vector<pot::metrics::executor_snapshot> &snapshots)
+    {
+        Executor executor(label, threads);
+        size_t executed_before = 0;
+
+        for (size_t round = 0; round < rounds; ++round)
+        {
+            std::latch done(static_cast<ptrdiff_t>(outer_jobs * (1 + inner_jobs)));
+            for (size_t i = 0; i < outer_jobs; ++i)
+            {
+                executor.run_detached([&]
+                                      {
+                    for (size_t j = 0; j < inner_jobs; ++j)
+                    {
+                        executor.run_detached([&done]
+                                              { done.count_down(); });
+                    }
+                    done.count_down(); });
+            }
+            done.wait();
+
+            // A job counts as executed only after it returned, which may be just after its count_down(). The idle
+            // spell lets the workers park; the time is recorded when shutdown wakes them.
+            if (round + 1 == rounds)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                executor.shutdown();
+            }
+            snapshots.push_back(executor.metrics());
+
+            const auto total = snapshots.back().total();
+            expect(total.executed >= executed_before, label, "executed never goes down between snapshots");
+            executed_before = total.executed;
+        }
+
+        const auto &last = snapshots.back();
+        const auto total = last.total();
+        const uint64_t jobs = rounds * outer_jobs * (1 + inner_jobs);
+
+        expect(last.workers.size() == threads, label, "one worker snapshot per thread");
+        expect(total.submitted == jobs, label, "submitted counts every job");
+        expect(total.executed == total.submitted, label, "executed == submitted once the pool is drained");
+        expect(total.stolen <= total.executed, label, "stolen jobs are a subset of executed ones");
+        expect(total.parked > std::chrono::nanoseconds(0), label, "idle workers record the time they parked");
+        expect(total.latency.count() > 0 && total.latency.count() <= total.executed, label,
+               "a sample of the jobs has a recorded latency");
+        expect(total.latency.percentile(0.5) <= total.latency.percentile(0.99), label, "p50 <= p99");
+
+        std::printf("%-4s threads=%zu submitted=%llu executed=%llu stolen=%llu parked=%.1f ms latency samples=%llu "
+                    "p50<=%lld ns p99<=%lld ns\n",
+                    label, threads, static_cast<unsigned long long>(total.submitted),
+                    static_cast<unsigned long long>(total.executed), static_cast<unsigned long long>(total.stolen),
+                    std::chrono::duration<double, std::milli>(total.parked).count(),
+                    static_cast<unsigned long long>(total.latency.count()),
+                    static_cast<long long>(total.latency.percentile(0.5).count()),
+                    static_cast<long long>(total.latency.percentile(0.99).count()));
+    }
+
+    size_t occurrences(const std::string &text, const std::string &pattern)
+    {
+        size_t count = 0;
+        for (size_t at = text.find(pattern); at != std::string::npos; at = text.find(pattern, at + 1))
+        {
+            ++count;
+        }
+        return count;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = argc > 1 ? argv[1] : "metrics_trace.json";
+    const size_t threads = 2;
+
+    std::vector<pot::metrics::executor_snapshot> snapshots;
+    run<pot::executors::thread_pool_executor_gq>("gq", threads, snapshots);
+    run<pot::executors::thread_pool_executor_lq>("lq", threads, snapshots);
+
+    std::ostringstream trace;
+    pot::metrics::write_chrome_trace(trace, snapshots);
+    const std::string json = trace.str();
+    expect(json.starts_with("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[") && json.ends_with("]}\n"), "trace",
+           "trace is one JSON object with a traceEvents array");
+    expect(occurrences(json, "\"ph\":\"M\"") == 2, "trace", "one process per executor");
+    expect(occurrences(json, "\"name\":\"task latency us\"") == snapshots.size(), "trace",
+           "one latency counter per snapshot");
+
+    std::ofstream file(path);
+    file << json;
+    expect(static_cast<bool>(file.flush()), "trace", "trace file written");
+    std::printf("wrote %zu snapshots to %s\n", snapshots.size(), path);
+
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+
+#include "../parallel_for.h"
+#include "../parfor.h"
+#include "../time_it.h"
+
+namespace
+{
+    void spin_work(size_t iterations)
+    {
+        volatile size_t sink = 0;
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            sink = sink + i;
+        }
+    }
+
+    // Cost grows with the index: static chunks give the last worker most of the work.
+    size_t ramp_cost(int i, int n) { return 20 + 2000 * static_cast<size_t>(i) / n; }
+
+    // The last 5% of the indices are 100x more expensive, all of them inside one static chunk.
+    size_t tail_cost(int i, int n) { return i >= n - n / 20 ? 4000 : 40; }
+
+    template <typename Executor, typename CostFunc>
+    void bench(const char *label, const char *shape, size_t threads, int n, CostFunc cost)
+    {
+        Executor executor("Main", threads);
+        auto visits = std::make_unique<std::atomic<int>[]>(n);
+
+        auto body = [&](int i)
+        {
+            spin_work(cost(i, n));
+            visits[i].fetch_add(1, std::memory_order_relaxed);
+        };
+
+        const pot::utils::benchmark_options options{.warm_up = 1, .samples = 9, .iterations = 1};
+        const auto static_time = pot::utils::benchmark(options, [&]
+                                                       { pot::algorithms::parfor(executor, 0, n, body).get(); });
+        const auto adaptive_time = pot::utils::benchmark(options, [&]
+                                                         { pot::algorithms::parallel_for(executor, 0, n, body).get(); });
+
+        const int runs = static_cast<int>(2 * (options.warm_up + options.samples));
+        for (int i = 0; i < n; ++i)
+        {
+            if (visits[i].load() != runs)
+            {
+                std::fprintf(stderr, "index %d visited %d times\n", i, visits[i].load());
+                std::exit(1);
+            }
+        }
+
+        std::printf("%-4s %-5s threads=%-3zu n=%-7d static=%8.0f us  adaptive=%8.0f us  (median of %zu)\n", label, shape,
+                    threads, n, static_time.median / 1e3, adaptive_time.median / 1e3, options.samples);
+    }
+}
+
+int main()
+{
+    const size_t cores = std::max<size_t>(1, std::thread::hardware_concurrency());
+    constexpr int n = 20000;
+
+    for (size_t threads : {cores, 2 * cores})
+    {
+        bench<pot::executors::thread_pool_executor_gq>("gq", "ramp", threads, n, ramp_cost);
+        bench<pot::executors::thread_pool_executor_lq>("lq", "ramp", threads, n, ramp_cost);
+        bench<pot::executors::thread_pool_executor_gq>("gq", "tail", threads, n, tail_cost);
+        bench<pot::executors::thread_pool_executor_lq>("lq", "tail", threads, n, tail_cost);
+    }
+
+    return 0;
+}
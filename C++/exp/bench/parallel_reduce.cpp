@@ -0,0 +1,90 @@
+// Needs the TBB backend for the std::execution::par baseline: g++ -std=c++23 -O2 -pthread parallel_reduce.cpp -ltbb
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <execution>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include "../parallel_numeric.h"
+#include "../thread_pool_executor.h"
+#include "../time_it.h"
+
+namespace
+{
+    void expect(bool condition, const char *what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAILED: %s\n", what);
+            std::exit(1);
+        }
+    }
+
+    template <typename Executor>
+    void bench(const char *label, size_t threads, size_t n)
+    {
+        Executor executor("Main", threads);
+
+        std::vector<double> a(n);
+        std::vector<double> b(n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            a[i] = 1.0 / static_cast<double>(i + 1);
+            b[i] = static_cast<double>(i % 7);
+        }
+
+        double reference = std::reduce(std::execution::seq, a.begin(), a.end(), 0.0);
+        double result = 0.0;
+
+        const auto std_time = pot::utils::time_it<std::chrono::microseconds>(10, [] {}, [&]
+                                                                              { result = std::reduce(std::execution::par, a.begin(), a.end(), 0.0); });
+        expect(std::abs(result - reference) < 1e-9, "std::reduce(par)");
+
+        const auto pot_time = pot::utils::time_it<std::chrono::microseconds>(10, [] {}, [&]
+                                                                              { result = pot::algorithms::parallel_reduce(executor, a.begin(), a.end(), 0.0).get(); });
+        expect(std::abs(result - reference) < 1e-9, "parallel_reduce");
+
+        double first = 0.0;
+        const auto deterministic_time = pot::utils::time_it<std::chrono::microseconds>(10, [] {}, [&]
+                                                                                        {
+            result = pot::algorithms::parallel_reduce(executor, a.begin(), a.end(), 0.0, std::plus<>{}, {.deterministic = true}).get();
+            if (first == 0.0)
+            {
+                first = result;
+            }
+            expect(result == first, "deterministic parallel_reduce is bit-identical"); });
+
+        const double dot_reference = std::transform_reduce(a.begin(), a.end(), b.begin(), 0.0);
+        const auto dot_time = pot::utils::time_it<std::chrono::microseconds>(10, [] {}, [&]
+                                                                              { result = pot::algorithms::parallel_transform_reduce(executor, a.begin(), a.end(), b.begin(), 0.0).get(); });
+        expect(std::abs(result - dot_reference) < 1e-6, "parallel_transform_reduce");
+
+        std::vector<double> scanned(n);
+        std::vector<double> scan_reference(n);
+        std::inclusive_scan(b.begin(), b.end(), scan_reference.begin());
+        const auto scan_time = pot::utils::time_it<std::chrono::microseconds>(10, [] {}, [&]
+                                                                               { pot::algorithms::parallel_inclusive_scan(executor, b.begin(), b.end(), scanned.begin()).get(); });
+        expect(scanned == scan_reference, "parallel_inclusive_scan");
+
+        std::printf("%-4s threads=%-3zu n=%-9zu std::reduce(par)=%7lld us  reduce=%7lld us  deterministic=%7lld us  dot=%7lld us  scan=%7lld us\n",
+                    label, threads, n, static_cast<long long>(std_time.count()), static_cast<long long>(pot_time.count()),
+                    static_cast<long long>(deterministic_time.count()), static_cast<long long>(dot_time.count()),
+                    static_cast<long long>(scan_time.count()));
+    }
+}
+
+int main()
+{
+    const size_t cores = std::max<size_t>(1, std::thread::hardware_concurrency());
+
+    for (size_t n : {size_t(1) << 12, size_t(1) << 20, size_t(1) << 24})
+    {
+        bench<pot::executors::thread_pool_executor_gq>("gq", cores, n);
+        bench<pot::executors::thread_pool_executor_lq>("lq", cores, n);
+    }
+
+    return 0;
+}
@@ -0,0 +1,163 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "../parfor.h"
+#include "../pipeline.h"
+#include "../thread_pool_executor.h"
+#include "../time_it.h"
+
+namespace
+{
+    using clock_type = std::chrono::steady_clock;
+
+    constexpr size_t items = 200'000;
+    constexpr size_t threads = 4;
+
+    struct item
+    {
+        size_t id;
+        clock_type::time_point created;
+        double value;
+        std::string text;
+    };
+
+    item generate(size_t id)
+    {
+        return {id, clock_type::now(), static_cast<double>(id % 1000) * 1e-3, {}};
+    }
+
+    // About a microsecond of arithmetic.
+    item compute(item it)
+    {
+        double x = it.value;
+        for (int i = 0; i < 64; ++i)
+        {
+            x = std::erf(x + 1e-3 * i);
+        }
+        it.value = x;
+        return it;
+    }
+
+    item scale(item it)
+    {
+        it.value = std::sqrt(std::abs(it.value)) * 3.0;
+        return it;
+    }
+
+    item format(item it)
+    {
+        char buffer[64];
+        std::snprintf(buffer, sizeof(buffer), "%zu:%.6f", it.id, it.value);
+        it.text = buffer;
+        return it;
+    }
+
+    // Single-threaded sink: records how long each item took from generation to being written.
+    struct writer
+    {
+        std::vector<double> latencies_us;
+        size_t bytes = 0;
+
+        writer() { latencies_us.reserve(items); }
+
+        void operator()(const item &it)
+        {
+            bytes += it.text.size();
+            latencies_us.push_back(std::chrono::duration<double, std::micro>(clock_type::now() - it.created).count());
+        }
+    };
+
+    void report(const char *label, size_t stages, clock_type::duration elapsed, writer &sink)
+    {
+        const double seconds = std::chrono::duration<double>(elapsed).count();
+        const auto latency = pot::utils::summarize(std::move(sink.latencies_us));
+        std::printf("%-24s %zu stages %10.0f items/s  latency p50 %9.1f us  p99 %9.1f us  (%zu bytes)\n", label, stages,
+                    static_cast<double>(items) / seconds, latency.median, latency.p99, sink.bytes);
+    }
+
+    // Today's shape: each stage fills a whole intermediate vector before the next one starts.
+    void buffered(pot::executor &executor, bool five_stages)
+    {
+        writer sink;
+        const auto start = clock_type::now();
+
+        std::vector<item> data;
+        data.reserve(items);
+        for (size_t i = 0; i < items; ++i)
+        {
+            data.push_back(generate(i));
+        }
+        auto run_stage = [&](auto stage)
+        {
+            pot::algorithms::parfor(executor, size_t(0), items, [&](size_t i)
+                                    { data[i] = stage(std::move(data[i])); })
+                .get();
+        };
+        run_stage(compute);
+        if (five_stages)
+        {
+            run_stage(scale);
+        }
+        run_stage(format);
+        for (const auto &it : data)
+        {
+            sink(it);
+        }
+
+        report("buffered vectors", five_stages ? 5 : 3, clock_type::now() - start, sink);
+    }
+
+    void streamed(pot::executor &executor, bool five_stages, size_t capacity)
+    {
+        writer sink;
+        const auto start = clock_type::now();
+
+        size_t next = 0;
+        auto source = [&]() -> std::optional<item>
+        {
+            if (next == items)
+            {
+                return std::nullopt;
+            }
+            return generate(next++);
+        };
+        auto write = [&](item it)
+        { sink(it); };
+
+        auto done = five_stages
+                        ? pot::make_pipeline(executor, source, capacity)
+                              .then(threads, compute)
+                              .then(1, scale)
+                              .then(2, format)
+                              .sink(1, write)
+                        : pot::make_pipeline(executor, source, capacity)
+                              .then(threads, compute)
+                              .sink(1, [&](item it)
+                                    { sink(format(std::move(it))); });
+        done.get();
+
+        char label[32];
+        std::snprintf(label, sizeof(label), "pipeline (capacity %zu)", capacity);
+        report(label, five_stages ? 5 : 3, clock_type::now() - start, sink);
+    }
+}
+
+int main()
+{
+    pot::executors::thread_pool_executor_gq executor("Pipeline", threads);
+
+    for (bool five_stages : {false, true})
+    {
+        buffered(executor, five_stages);
+        for (size_t capacity : {16, 256})
+        {
+            streamed(executor, five_stages, capacity);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <vector>
+
+#include "../priority_executor.h"
+#include "../thread_pool_executor.h"
+
+namespace
+{
+    using clock_type = std::chrono::steady_clock;
+
+    constexpr size_t background_jobs = 20000;
+    constexpr size_t probes = 200;
+    constexpr auto background_cost = std::chrono::microseconds(20);
+    constexpr auto probe_interval = std::chrono::microseconds(500);
+
+    void burn(std::chrono::microseconds duration)
+    {
+        const auto until = clock_type::now() + duration;
+        while (clock_type::now() < until)
+        {
+        }
+    }
+
+    // Floods the executor with low-priority batch work, then measures how long latency-critical probes wait
+    // before they start. Without lanes the probes queue behind the whole backlog.
+    template <typename UrgentHint>
+    void bench(const char *label, pot::executor &executor, pot::schedule_hint background, UrgentHint urgent)
+    {
+        std::vector<std::future<void>> batch;
+        batch.reserve(background_jobs);
+        for (size_t i = 0; i < background_jobs; ++i)
+        {
+            batch.push_back(executor.run(background, []
+                                         { burn(background_cost); }));
+        }
+
+        std::vector<std::future<clock_type::duration>> waits;
+        for (size_t i = 0; i < probes; ++i)
+        {
+            waits.push_back(executor.run(urgent(), [submitted_at = clock_type::now()]
+                                         { return clock_type::now() - submitted_at; }));
+            std::this_thread::sleep_for(probe_interval);
+        }
+
+        std::vector<double> micros;
+        for (auto &wait : waits)
+        {
+            micros.push_back(std::chrono::duration<double, std::micro>(wait.get()).count());
+        }
+        for (auto &job : batch)
+        {
+            job.get();
+        }
+
+        std::ranges::sort(micros);
+        std::printf("%-36s probe wait p50 %10.1f us   p99 %10.1f us\n", label,
+                    micros[micros.size() / 2], micros[micros.size() * 99 / 100]);
+    }
+}
+
+int main()
+{
+    const size_t threads = std::max<size_t>(2, std::thread::hardware_concurrency());
+
+    {
+        pot::executors::thread_pool_executor_gq executor("FIFO", threads);
+        bench("thread_pool_executor_gq (FIFO)", executor, {}, []
+              { return pot::schedule_hint{}; });
+    }
+    {
+        pot::executors::priority_executor executor("Priority", threads);
+        bench("priority_executor high vs low", executor, pot::priority::low, []
+              { return pot::schedule_hint{pot::priority::high}; });
+    }
+    {
+        pot::executors::priority_executor executor("Priority", threads);
+        bench("priority_executor deadline vs low", executor, pot::priority::low, []
+              { return pot::schedule_hint::within(std::chrono::milliseconds(1)); });
+
+        for (const auto &lane : executor.metrics().lanes)
+        {
+            std::printf("  %-8s lane: submitted %6llu promoted %6llu missed %6llu wait p99 %10.1f us\n",
+                        lane.name.c_str(), static_cast<unsigned long long>(lane.submitted),
+                        static_cast<unsigned long long>(lane.promoted), static_cast<unsigned long long>(lane.missed_deadlines),
+                        std::chrono::duration<double, std::micro>(lane.wait.percentile(0.99)).count());
+        }
+    }
+
+    return 0;
+}
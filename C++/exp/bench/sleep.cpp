@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "../sleep.h"
+#include "../thread_pool_executor.h"
+#include "../when_all.h"
+
+namespace
+{
+    using clock_type = std::chrono::steady_clock;
+
+    constexpr size_t coroutines = 1000;
+    constexpr size_t naps = 3;
+    constexpr auto nap = std::chrono::milliseconds(50);
+
+    // How late each wake-up was, in microseconds.
+    pot::coroutines::task<std::vector<double>> sleeper()
+    {
+        std::vector<double> lateness;
+        for (size_t i = 0; i < naps; ++i)
+        {
+            const auto due = clock_type::now() + nap;
+            co_await pot::sleep_until(due);
+            lateness.push_back(std::chrono::duration<double, std::micro>(clock_type::now() - due).count());
+        }
+        co_return lateness;
+    }
+
+    template <typename Executor>
+    void bench(const char *label, size_t threads)
+    {
+        Executor executor("Sleepers", threads);
+
+        const auto start = clock_type::now();
+        std::vector<pot::coroutines::task<std::vector<double>>> tasks;
+        tasks.reserve(coroutines);
+        for (size_t i = 0; i < coroutines; ++i)
+        {
+            tasks.push_back(executor.run(sleeper));
+        }
+        const auto results = pot::when_all(std::move(tasks)).get();
+        const double elapsed = std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+
+        std::vector<double> lateness;
+        for (const auto &result : results)
+        {
+            lateness.insert(lateness.end(), result.begin(), result.end());
+        }
+        std::ranges::sort(lateness);
+        // Blocking sleeps would keep every worker busy for coroutines * naps * nap / threads.
+        std::printf("%-8s %zu coroutines x %zu x %lld ms on %zu threads: %8.1f ms total, lateness p50 %7.0f us p99 %7.0f us\n",
+                    label, coroutines, naps, static_cast<long long>(nap.count()), threads, elapsed,
+                    lateness[lateness.size() / 2], lateness[lateness.size() * 99 / 100]);
+    }
+
+    // Shutting down with sleepers pending cuts their sleeps short: every one resumes, with operation_cancelled,
+    // instead of hanging its awaiter and leaking its frame.
+    template <typename Executor>
+    void shutdown_wakes_sleepers(const char *label)
+    {
+        constexpr size_t sleepers = 100;
+        std::atomic<size_t> cancelled{0};
+        std::vector<pot::coroutines::task<void>> tasks;
+        {
+            Executor executor("Sleepers", 2);
+            for (size_t i = 0; i < sleepers; ++i)
+            {
+                tasks.push_back(executor.run([&cancelled]() -> pot::coroutines::task<void>
+                                             {
+                    try
+                    {
+                        auto nap = pot::sleep_for(std::chrono::hours(1));
+                        co_await nap;
+                    }
+                    catch (const pot::operation_cancelled &)
+                    {
+                        cancelled.fetch_add(1, std::memory_order_relaxed);
+                    } }));
+            }
+            while (executor.timers().pending() < sleepers)
+            {
+                std::this_thread::yield();
+            }
+            executor.shutdown();
+        }
+        for (auto &task : tasks)
+        {
+            task.get();
+        }
+        if (cancelled.load() != sleepers)
+        {
+            std::fprintf(stderr, "%s: %zu of %zu sleepers cancelled on shutdown\n", label, cancelled.load(), sleepers);
+            std::exit(1);
+        }
+        std::printf("%-8s shutdown resumed all %zu pending sleepers\n", label, sleepers);
+    }
+}
+
+int main()
+{
+    shutdown_wakes_sleepers<pot::executors::thread_pool_executor_gq>("gq");
+    shutdown_wakes_sleepers<pot::executors::thread_pool_executor_lq>("lq");
+
+    bench<pot::executors::thread_pool_executor_gq>("gq", 2);
+    bench<pot::executors::thread_pool_executor_lq>("lq", 2);
+
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <latch>
+#include <vector>
+
+#include "../thread_pool_executor.h"
+#include "../time_it.h"
+
+namespace
+{
+    constexpr size_t tasks_per_run = 200000;
+
+    void report(const char *label, std::chrono::nanoseconds duration)
+    {
+        const double seconds = std::chrono::duration<double>(duration).count();
+        std::printf("%-32s %12.0f tasks/s\n", label, static_cast<double>(tasks_per_run) / seconds);
+    }
+
+    template <typename Executor>
+    void bench_run_detached(const char *label, size_t threads, pot::executors::thread_pool_options options = {})
+    {
+        Executor executor("Main", threads, options);
+
+        report(label, pot::utils::time_it<std::chrono::nanoseconds>(5, [] {}, [&]
+                                                                     {
+            std::latch done(static_cast<ptrdiff_t>(tasks_per_run));
+            for (size_t i = 0; i < tasks_per_run; ++i)
+            {
+                executor.run_detached([&done]
+                                      { done.count_down(); });
+            }
+            done.wait(); }));
+    }
+
+    // Same as above but with a capture the size of parfor's chunk lambdas, which no longer fits std::function's local buffer.
+    template <typename Executor>
+    void bench_run_detached_large(const char *label, size_t threads)
+    {
+        Executor executor("Main", threads);
+
+        report(label, pot::utils::time_it<std::chrono::nanoseconds>(5, [] {}, [&]
+                                                                     {
+            std::latch done(static_cast<ptrdiff_t>(tasks_per_run));
+            for (size_t i = 0; i < tasks_per_run; ++i)
+            {
+                executor.run_detached([&done, from = i, to = i + 1, step = size_t(1), payload = 0.0]
+                                      { done.count_down(static_cast<ptrdiff_t>((to - from) * step) + static_cast<ptrdiff_t>(payload)); });
+            }
+            done.wait(); }));
+    }
+
+    // The same jobs handed over in batches: one queue operation and one wake-up round per batch.
+    template <typename Executor>
+    void bench_submit_batch(const char *label, size_t threads, size_t batch_size)
+    {
+        Executor executor("Main", threads);
+
+        report(label, pot::utils::time_it<std::chrono::nanoseconds>(5, [] {}, [&]
+                                                                     {
+            std::latch done(static_cast<ptrdiff_t>(tasks_per_run));
+            auto job = [&done]
+            { done.count_down(); };
+            for (size_t submitted = 0; submitted < tasks_per_run; submitted += batch_size)
+            {
+                std::vector<decltype(job)> batch(std::min(batch_size, tasks_per_run - submitted), job);
+                executor.submit_batch(batch);
+            }
+            done.wait(); }));
+    }
+
+    template <typename Executor>
+    void bench_run(const char *label, size_t threads)
+    {
+        Executor executor("Main", threads);
+        std::vector<std::future<size_t>> futures;
+        futures.reserve(tasks_per_run);
+
+        report(label, pot::utils::time_it<std::chrono::nanoseconds>(5, [&]
+                                                                     { futures.clear(); }, [&]
+                                                                     {
+            for (size_t i = 0; i < tasks_per_run; ++i)
+            {
+                futures.push_back(executor.run([i]
+                                               { return i; }));
+            }
+            for (auto &future : futures)
+            {
+                future.get();
+            } }));
+    }
+}
+
+int main()
+{
+    const size_t threads = std::max<size_t>(2, std::thread::hardware_concurrency());
+
+    bench_run_detached<pot::executors::thread_pool_executor_gq>("run_detached gq", threads);
+    bench_run_detached<pot::executors::thread_pool_executor_lq>("run_detached lq", threads);
+    bench_run_detached<pot::executors::thread_pool_executor_gq>("run_detached gq, spin_budget=0", threads, {.spin_budget = 0});
+    bench_run_detached<pot::executors::thread_pool_executor_lq>("run_detached lq, spin_budget=0", threads, {.spin_budget = 0});
+    bench_run_detached_large<pot::executors::thread_pool_executor_gq>("run_detached 40B capture gq", threads);
+    bench_run_detached_large<pot::executors::thread_pool_executor_lq>("run_detached 40B capture lq", threads);
+    bench_submit_batch<pot::executors::thread_pool_executor_gq>("submit_batch(10k) gq", threads, 10000);
+    bench_submit_batch<pot::executors::thread_pool_executor_lq>("submit_batch(10k) lq", threads, 10000);
+    bench_run<pot::executors::thread_pool_executor_gq>("run (future) gq", threads);
+    bench_run<pot::executors::thread_pool_executor_lq>("run (future) lq", threads);
+
+    return 0;
+}
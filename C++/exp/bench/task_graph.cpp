@@ -0,0 +1,191 @@
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "../parfor.h"
+#include "../task_graph.h"
+#include "../thread_pool_executor.h"
+#include "../time_it.h"
+
+namespace
+{
+    constexpr size_t threads = 4;
+
+    double ms(std::chrono::nanoseconds duration)
+    {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+
+    // Deep: a chain of dependent steps. By hand every step is its own co_await executor.run(...).
+    constexpr size_t chain_length = 50'000;
+
+    pot::coroutines::task<void> step(long &value)
+    {
+        ++value;
+        co_return;
+    }
+
+    pot::coroutines::task<void> chain_by_hand(pot::executor &executor, long &value)
+    {
+        for (size_t i = 0; i < chain_length; ++i)
+        {
+            co_await executor.run(step, std::ref(value));
+        }
+    }
+
+    void deep(pot::executor &executor)
+    {
+        long value = 0;
+        const auto by_hand = pot::utils::time_it<std::chrono::nanoseconds>(5, [] {}, [&]
+                                                                           { chain_by_hand(executor, value).get(); });
+
+        pot::task_graph graph;
+        auto previous = graph.emplace([&]
+                                      { ++value; });
+        for (size_t i = 1; i < chain_length; ++i)
+        {
+            auto next = graph.emplace([&]
+                                      { ++value; });
+            previous.precede(next);
+            previous = next;
+        }
+        const auto graph_run = pot::utils::time_it<std::chrono::nanoseconds>(5, [] {}, [&]
+                                                                             { graph.run(executor).get(); });
+
+        // The same chain of coroutine nodes. Each completes synchronously, so the whole chain runs inside one
+        // runner frame; this also checks it does so at constant stack depth.
+        pot::task_graph task_chain;
+        auto previous_task = task_chain.emplace([&]() -> pot::coroutines::task<void>
+                                                { ++value; co_return; });
+        for (size_t i = 1; i < chain_length; ++i)
+        {
+            auto next = task_chain.emplace([&]() -> pot::coroutines::task<void>
+                                           { ++value; co_return; });
+            previous_task.precede(next);
+            previous_task = next;
+        }
+        const auto task_chain_run = pot::utils::time_it<std::chrono::nanoseconds>(5, [] {}, [&]
+                                                                                  { task_chain.run(executor).get(); });
+
+        std::printf("deep  chain of %zu:        co_await run() %7.2f ms   task_graph %7.2f ms   task nodes %7.2f ms\n",
+                    chain_length, ms(by_hand), ms(graph_run), ms(task_chain_run));
+    }
+
+    // Wide: one root, many independent nodes, one sink.
+    constexpr size_t width = 50'000;
+
+    void wide(pot::executor &executor)
+    {
+        std::vector<double> data(width, 1.0);
+        auto work = [&](size_t i)
+        { data[i] = data[i] * 1.0001 + 1.0; };
+
+        const auto bulk = pot::utils::time_it<std::chrono::nanoseconds>(5, [] {}, [&]
+                                                                        { executor.run_bulk(std::views::iota(size_t(0), width), work).get(); });
+
+        pot::task_graph graph;
+        auto root = graph.emplace([] {});
+        auto sink = graph.emplace([] {});
+        for (size_t i = 0; i < width; ++i)
+        {
+            auto node = graph.emplace([&work, i]
+                                      { work(i); });
+            root.precede(node);
+            sink.succeed(node);
+        }
+        const auto graph_run = pot::utils::time_it<std::chrono::nanoseconds>(5, [] {}, [&]
+                                                                             { graph.run(executor).get(); });
+
+        std::printf("wide  fan-out of %zu:      run_bulk       %7.2f ms   task_graph %7.2f ms\n", width, ms(bulk),
+                    ms(graph_run));
+    }
+
+    // Stencil sweep: block b at step t needs blocks b-1, b, b+1 of step t-1. A barrier per step makes every block
+    // wait for the slowest one; the graph lets each block go as soon as its three inputs are done.
+    constexpr size_t blocks = 64;
+    constexpr size_t block_size = 4096;
+    constexpr size_t steps = 64;
+
+    struct grid
+    {
+        std::vector<double> buffers[2] = {std::vector<double>(blocks * block_size, 1.0),
+                                          std::vector<double>(blocks * block_size, 1.0)};
+
+        void update(size_t t, size_t b)
+        {
+            const auto &in = buffers[(t + 1) % 2];
+            auto &out = buffers[t % 2];
+            const size_t first = b * block_size;
+            for (size_t i = first; i < first + block_size; ++i)
+            {
+                const double left = i > 0 ? in[i - 1] : in[i];
+                const double right = i + 1 < in.size() ? in[i + 1] : in[i];
+                out[i] = 0.25 * left + 0.5 * in[i] + 0.25 * right;
+            }
+        }
+    };
+
+    pot::coroutines::task<void> sweep_with_barriers(pot::executor &executor, grid &g)
+    {
+        for (size_t t = 1; t <= steps; ++t)
+        {
+            auto sweep = pot::algorithms::parfor<1>(executor, size_t(0), blocks, [&g, t](size_t b)
+                                                    { g.update(t, b); });
+            co_await sweep;
+        }
+    }
+
+    void stencil(pot::executor &executor)
+    {
+        grid g;
+        const auto barriers = pot::utils::time_it<std::chrono::nanoseconds>(5, [] {}, [&]
+                                                                            { sweep_with_barriers(executor, g).get(); });
+
+        const auto build_start = std::chrono::steady_clock::now();
+        pot::task_graph graph;
+        std::vector<pot::task_graph::node> previous;
+        for (size_t t = 1; t <= steps; ++t)
+        {
+            std::vector<pot::task_graph::node> current;
+            current.reserve(blocks);
+            for (size_t b = 0; b < blocks; ++b)
+            {
+                auto node = graph.emplace([&g, t, b]
+                                          { g.update(t, b); });
+                if (!previous.empty())
+                {
+                    node.succeed(previous[b]);
+                    if (b > 0)
+                    {
+                        node.succeed(previous[b - 1]);
+                    }
+                    if (b + 1 < blocks)
+                    {
+                        node.succeed(previous[b + 1]);
+                    }
+                }
+                current.push_back(node);
+            }
+            previous = std::move(current);
+        }
+        graph.run(executor).get();
+        const auto first_run = std::chrono::steady_clock::now() - build_start;
+
+        const auto rerun = pot::utils::time_it<std::chrono::nanoseconds>(5, [] {}, [&]
+                                                                         { graph.run(executor).get(); });
+
+        std::printf("stencil %zu blocks x %zu steps: barrier/step %7.2f ms   task_graph %7.2f ms (build + first run %.2f ms)\n",
+                    blocks, steps, ms(barriers), ms(rerun), ms(first_run));
+    }
+}
+
+int main()
+{
+    pot::executors::thread_pool_executor_lq executor("Graph", threads);
+
+    deep(executor);
+    wide(executor);
+    stencil(executor);
+
+    return 0;
+}
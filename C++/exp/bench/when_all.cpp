@@ -0,0 +1,154 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+#include "../thread_pool_executor.h"
+#include "../when_all.h"
+
+namespace
+{
+    void expect(bool condition, const char *what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAILED: %s\n", what);
+            std::exit(1);
+        }
+    }
+
+    std::vector<pot::coroutines::task<size_t>> children(pot::executor &executor, size_t width)
+    {
+        std::vector<pot::coroutines::task<size_t>> tasks;
+        tasks.reserve(width);
+        for (size_t i = 0; i < width; ++i)
+        {
+            tasks.push_back(executor.run([i]() -> pot::coroutines::task<size_t>
+                                         { co_return i; }));
+        }
+        return tasks;
+    }
+
+    // Many tiny children finish on different workers at the same time, so the countdown is hit from every
+    // thread at once; the join must still resume exactly once and keep results in input order. With a token the
+    // same join goes through the cancellable path, which also races the stop callback registration.
+    pot::coroutines::task<size_t> fan_in(pot::executor &executor, size_t width, bool with_token = false)
+    {
+        std::stop_source source;
+        auto all = with_token ? pot::when_all(children(executor, width), source.get_token())
+                              : pot::when_all(children(executor, width));
+        const auto results = co_await all;
+        expect(results.size() == width, "when_all returns one result per task");
+        size_t sum = 0;
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            expect(results[i] == i, "when_all keeps input order");
+            sum += results[i];
+        }
+        co_return sum;
+    }
+
+    pot::coroutines::task<void> mixed(pot::executor &executor)
+    {
+        auto variadic = pot::when_all(
+            executor.run([]() -> pot::coroutines::task<int>
+                         { co_return 1; }),
+            executor.run([]() -> pot::coroutines::task<void>
+                         { co_return; }),
+            executor.run([]() -> pot::coroutines::task<double>
+                         { co_return 2.5; }));
+        auto [a, b, c] = co_await variadic;
+        expect(a == 1 && c == 2.5, "variadic when_all");
+
+        std::vector<pot::coroutines::task<int>> failing;
+        failing.push_back(executor.run([]() -> pot::coroutines::task<int>
+                                       { co_return 1; }));
+        failing.push_back(executor.run([]() -> pot::coroutines::task<int>
+                                       { throw std::runtime_error("boom"); co_return 0; }));
+        bool thrown = false;
+        try
+        {
+            auto all = pot::when_all(std::move(failing));
+            co_await all;
+        }
+        catch (const std::runtime_error &)
+        {
+            thrown = true;
+        }
+        expect(thrown, "when_all rethrows a child's exception");
+    }
+
+    // Every child races for the win; only one may resume the awaiter, the rest must finish on their own.
+    pot::coroutines::task<void> race(pot::executor &executor, size_t width)
+    {
+        auto any = pot::when_any(children(executor, width));
+        const auto result = co_await any;
+        expect(result.index < width && result.value == result.index, "when_any reports its winner");
+    }
+
+    template <typename Executor>
+    void bench(const char *label, size_t threads, size_t width, size_t rounds)
+    {
+        Executor executor("Main", threads);
+
+        const size_t sum = width * (width - 1) / 2;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t r = 0; r < rounds; ++r)
+        {
+            expect(fan_in(executor, width).get() == sum, "when_all sum");
+        }
+        const auto all_time = std::chrono::steady_clock::now() - start;
+
+        for (size_t r = 0; r < rounds / 4; ++r)
+        {
+            expect(fan_in(executor, width, true).get() == sum, "when_all with a token sum");
+        }
+
+        const auto any_start = std::chrono::steady_clock::now();
+        for (size_t r = 0; r < rounds; ++r)
+        {
+            race(executor, width).get();
+        }
+        const auto any_time = std::chrono::steady_clock::now() - any_start;
+
+        // Several external threads join concurrently on the same pool.
+        {
+            std::vector<std::jthread> awaiters;
+            for (size_t t = 0; t < threads; ++t)
+            {
+                awaiters.emplace_back([&]
+                                      {
+                    for (size_t r = 0; r < rounds / 4; ++r)
+                    {
+                        expect(fan_in(executor, width, r % 2 == 1).get() == sum, "concurrent when_all");
+                        race(executor, width).get();
+                    } });
+            }
+        }
+        mixed(executor).get();
+
+        std::printf("%-4s threads=%-3zu width=%-6zu when_all=%8.2f us/round  when_any=%8.2f us/round\n", label, threads,
+                    width, std::chrono::duration<double, std::micro>(all_time).count() / rounds,
+                    std::chrono::duration<double, std::micro>(any_time).count() / rounds);
+    }
+}
+
+int main()
+{
+    const size_t cores = std::max<size_t>(2, std::thread::hardware_concurrency());
+
+    for (size_t threads : {size_t(1), cores, 2 * cores})
+    {
+        for (size_t width : {1, 2, 16, 1024})
+        {
+            bench<pot::executors::thread_pool_executor_gq>("gq", threads, width, 200);
+            bench<pot::executors::thread_pool_executor_lq>("lq", threads, width, 200);
+        }
+    }
+    std::printf("all when_all/when_any checks passed\n");
+
+    return 0;
+}
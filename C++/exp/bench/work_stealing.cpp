@@ -0,0 +1,91 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <latch>
+
+#include "../thread_pool_executor.h"
+#include "../time_it.h"
+
+namespace
+{
+    void spin_work(size_t iterations)
+    {
+        volatile size_t sink = 0;
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            sink = sink + i;
+        }
+    }
+
+    // Binary fan-out: every inner node submits its two children from inside a worker,
+    // so all the work starts on one deque and the other workers have to steal it.
+    void spawn_tree(pot::executor &executor, size_t depth, size_t leaf_work, std::latch &done)
+    {
+        if (depth == 0)
+        {
+            spin_work(leaf_work);
+            done.count_down();
+            return;
+        }
+
+        for (int child = 0; child < 2; ++child)
+        {
+            executor.run_detached([&executor, depth, leaf_work, &done]
+                                  { spawn_tree(executor, depth - 1, leaf_work, done); });
+        }
+    }
+
+    template <typename Executor>
+    void bench_fan_out(const char *label, size_t threads, size_t depth, size_t leaf_work)
+    {
+        Executor executor("Main", threads);
+
+        const auto duration = pot::utils::time_it<std::chrono::microseconds>(5, [] {}, [&]
+                                                                             {
+            std::latch done(ptrdiff_t(1) << depth);
+            executor.run_detached([&executor, depth, leaf_work, &done]
+                                  { spawn_tree(executor, depth, leaf_work, done); });
+            done.wait(); });
+
+        std::printf("%-24s threads=%-3zu depth=%-3zu leaf_work=%-6zu %10lld us\n",
+                    label, threads, depth, leaf_work, static_cast<long long>(duration.count()));
+    }
+
+    template <typename Executor>
+    void bench_flat(const char *label, size_t threads, size_t tasks, size_t leaf_work)
+    {
+        Executor executor("Main", threads);
+
+        const auto duration = pot::utils::time_it<std::chrono::microseconds>(5, [] {}, [&]
+                                                                             {
+            std::latch done(static_cast<ptrdiff_t>(tasks));
+            for (size_t i = 0; i < tasks; ++i)
+            {
+                executor.run_detached([leaf_work, &done]
+                                      { spin_work(leaf_work); done.count_down(); });
+            }
+            done.wait(); });
+
+        std::printf("%-24s threads=%-3zu tasks=%-7zu leaf_work=%-6zu %10lld us\n",
+                    label, threads, tasks, leaf_work, static_cast<long long>(duration.count()));
+    }
+}
+
+int main()
+{
+    const size_t threads = std::max<size_t>(2, std::thread::hardware_concurrency());
+
+    for (size_t leaf_work : {0, 1000})
+    {
+        bench_fan_out<pot::executors::thread_pool_executor_gq>("fan-out gq", threads, 14, leaf_work);
+        bench_fan_out<pot::executors::thread_pool_executor_lq>("fan-out lq", threads, 14, leaf_work);
+    }
+
+    for (size_t leaf_work : {0, 1000})
+    {
+        bench_flat<pot::executors::thread_pool_executor_gq>("flat gq", threads, 20000, leaf_work);
+        bench_flat<pot::executors::thread_pool_executor_lq>("flat lq", threads, 20000, leaf_work);
+    }
+
+    return 0;
+}
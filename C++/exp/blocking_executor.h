@@ -0,0 +1,273 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "executor.h"
+
+namespace pot::executors
+{
+    struct blocking_executor_options
+    {
+        // Upper bound on threads; beyond it jobs queue up.
+        size_t max_threads = 512;
+
+        // A thread that found nothing to do for this long exits.
+        std::chrono::steady_clock::duration idle_timeout = std::chrono::seconds(10);
+    };
+
+    // Elastic pool for jobs that block (sockets, files, sleeps, locks held by others). It starts with no threads,
+    // adds one whenever a job arrives and no idle thread is left to take it, and lets threads go after
+    // idle_timeout. Keep compute on a thread_pool_executor sized to the cores and send the blocking parts here,
+    // e.g. with co_await pot::offload_blocking(f).
+    class blocking_executor final : public executor
+    {
+    public:
+        explicit blocking_executor(std::string name, blocking_executor_options options = {})
+            : executor(std::move(name)), m_options(options) {}
+
+        ~blocking_executor() override { shutdown(); }
+
+        // Runs the jobs already queued, then joins every thread. Jobs submitted afterwards throw.
+        void shutdown() override
+        {
+            stop_timers();
+
+            std::list<std::thread> threads;
+            {
+                std::unique_lock lock(m_mutex);
+                m_shutdown = true;
+                m_wake.notify_all();
+                m_exited.wait(lock, [&]
+                              { return m_thread_count == 0; });
+                threads = std::move(m_threads);
+                m_retired.clear();
+            }
+            for (auto &thread : threads)
+            {
+                thread.join();
+            }
+        }
+
+        [[nodiscard]] size_t thread_count() const override
+        {
+            std::lock_guard lock(m_mutex);
+            return m_thread_count;
+        }
+
+        [[nodiscard]] size_t peak_thread_count() const
+        {
+            std::lock_guard lock(m_mutex);
+            return m_peak_thread_count;
+        }
+
+    protected:
+        void derived_execute(details::unique_function<void()> func) override
+        {
+            std::vector<std::thread> retired;
+            {
+                std::lock_guard lock(m_mutex);
+                if (m_shutdown)
+                {
+                    throw std::runtime_error("blocking_executor is shut down.");
+                }
+                m_tasks.push_back(std::move(func));
+                if (m_tasks.size() > m_idle_count && m_thread_count < m_options.max_threads)
+                {
+                    spawn();
+                }
+                else
+                {
+                    m_wake.notify_one();
+                }
+                retired = take_retired();
+            }
+            for (auto &thread : retired)
+            {
+                thread.join();
+            }
+        }
+
+    private:
+        // Called with m_mutex held.
+        void spawn()
+        {
+            ++m_thread_count;
+            m_peak_thread_count = std::max(m_peak_thread_count, m_thread_count);
+            auto slot = m_threads.emplace(m_threads.end());
+            *slot = std::thread([this, slot]
+                                { thread_loop(slot); });
+        }
+
+        // Threads that timed out have left thread_loop; they are joined by whoever submits next.
+        std::vector<std::thread> take_retired()
+        {
+            std::vector<std::thread> retired;
+            retired.reserve(m_retired.size());
+            for (auto slot : m_retired)
+            {
+                retired.push_back(std::move(*slot));
+                m_threads.erase(slot);
+            }
+            m_retired.clear();
+            return retired;
+        }
+
+        void thread_loop(std::list<std::thread>::iterator slot)
+        {
+            std::unique_lock lock(m_mutex);
+            while (true)
+            {
+                if (!m_tasks.empty())
+                {
+                    auto task = std::move(m_tasks.front());
+                    m_tasks.pop_front();
+                    lock.unlock();
+                    task();
+                    // Destroyed before relocking: the job's captures may submit more work.
+                    task = nullptr;
+                    lock.lock();
+                    continue;
+                }
+                if (m_shutdown)
+                {
+                    break;
+                }
+
+                ++m_idle_count;
+                const bool woken = m_wake.wait_for(lock, m_options.idle_timeout, [&]
+                                                   { return !m_tasks.empty() || m_shutdown; });
+                --m_idle_count;
+                if (!woken)
+                {
+                    m_retired.push_back(slot);
+                    break;
+                }
+            }
+
+            --m_thread_count;
+            m_exited.notify_all();
+        }
+
+        blocking_executor_options m_options;
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::condition_variable m_exited;
+        std::deque<details::unique_function<void()>> m_tasks;
+
+        std::list<std::thread> m_threads;
+        std::vector<std::list<std::thread>::iterator> m_retired;
+        size_t m_thread_count = 0;
+        size_t m_idle_count = 0;
+        size_t m_peak_thread_count = 0;
+        bool m_shutdown = false;
+    };
+}
+
+namespace pot
+{
+    // The process-wide blocking_executor used by offload_blocking(f).
+    [[nodiscard]] inline executors::blocking_executor &default_blocking_executor()
+    {
+        static executors::blocking_executor instance("Blocking");
+        return instance;
+    }
+
+    // Runs func on the blocking executor and resumes the coroutine on the executor it was running on, so the
+    // compute worker is free while func blocks. Outside an executor the coroutine continues on the blocking
+    // thread. func's result (or exception) becomes the result of the co_await.
+    template <typename Func>
+    class offload_awaitable
+    {
+    public:
+        using result_type = std::invoke_result_t<Func &>;
+
+        template <typename F>
+        offload_awaitable(executor &blocking, F &&func) : m_blocking(blocking), m_func(std::in_place, std::forward<F>(func)) {}
+
+        bool await_ready() const noexcept { return false; }
+
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            m_blocking.run_detached([this, handle, origin = executor::current()]
+                                    {
+                try
+                {
+                    if constexpr (std::is_void_v<result_type>)
+                    {
+                        std::invoke(*m_func);
+                    }
+                    else
+                    {
+                        m_result.emplace(std::invoke(*m_func));
+                    }
+                }
+                catch (...)
+                {
+                    m_exception = std::current_exception();
+                }
+                // The captures are released on the blocking thread, before the coroutine moves on.
+                m_func.reset();
+
+                if (origin)
+                {
+                    origin->run_detached([handle]
+                                         { handle.resume(); });
+                }
+                else
+                {
+                    handle.resume();
+                } });
+        }
+
+        result_type await_resume()
+        {
+            if (m_exception)
+            {
+                std::rethrow_exception(m_exception);
+            }
+            if constexpr (!std::is_void_v<result_type>)
+            {
+                return static_cast<result_type>(std::move(*m_result));
+            }
+        }
+
+    private:
+        using storage_type = std::conditional_t<std::is_reference_v<result_type>,
+                                                std::reference_wrapper<std::remove_reference_t<result_type>>,
+                                                result_type>;
+
+        executor &m_blocking;
+        std::optional<Func> m_func;
+        std::optional<std::conditional_t<std::is_void_v<result_type>, std::monostate, storage_type>> m_result;
+        std::exception_ptr m_exception;
+    };
+
+    template <typename Func>
+        requires std::is_invocable_v<std::decay_t<Func> &>
+    [[nodiscard]] offload_awaitable<std::decay_t<Func>> offload_blocking(executor &blocking, Func &&func)
+    {
+        return {blocking, std::forward<Func>(func)};
+    }
+
+    template <typename Func>
+        requires std::is_invocable_v<std::decay_t<Func> &>
+    [[nodiscard]] offload_awaitable<std::decay_t<Func>> offload_blocking(Func &&func)
+    {
+        return {default_blocking_executor(), std::forward<Func>(func)};
+    }
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstddef>
+
+namespace pot::details
+{
+    // std::hardware_destructive_interference_size is ABI-unstable in GCC (-Winterference-size),
+    // so the padding used by the lock-free structures is pinned here instead.
+    inline constexpr std::size_t cache_line_size = 64;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdexcept>
+#include <stop_token>
+
+namespace pot
+{
+    // Cancellation is cooperative and uses the standard std::stop_source / std::stop_token pair: hand the token
+    // to executor::run, parfor or when_all and call request_stop() on the source. Jobs that have not started yet
+    // are dropped, awaiters of cancelled work get operation_cancelled, and running code can poll the token.
+    class operation_cancelled : public std::runtime_error
+    {
+    public:
+        operation_cancelled() : std::runtime_error("Operation cancelled.") {}
+    };
+
+    inline void throw_if_cancelled(const std::stop_token &token)
+    {
+        if (token.stop_requested())
+        {
+            throw operation_cancelled();
+        }
+    }
+}
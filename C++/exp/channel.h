@@ -0,0 +1,296 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+#include "executor.h"
+
+namespace pot
+{
+    // Bounded multi-producer multi-consumer queue for coroutines. co_await ch.send(x) suspends while the
+    // channel is full and co_await ch.recv() while it is empty, so a fast producer is held back by a slow consumer
+    // instead of buffering without bound. A capacity of 0 makes every send wait for a receiver (a rendezvous).
+    //
+    // A suspended coroutine is resumed on the executor it was suspended on (executor::current()), or inline by
+    // the waking thread if it was not running on a worker.
+    //
+    // close() ends the stream: receivers still get what is buffered and then nullopt, senders get false.
+    template <typename T>
+    class channel
+    {
+        struct waiter
+        {
+            std::coroutine_handle<> m_handle;
+            executor *m_executor = nullptr;
+            waiter *m_next = nullptr;
+
+            void wake() const
+            {
+                if (m_executor)
+                {
+                    m_executor->run_detached([handle = m_handle]
+                                             { handle.resume(); });
+                }
+                else
+                {
+                    m_handle.resume();
+                }
+            }
+        };
+
+        // FIFO of suspended awaiters; they live in the awaiting coroutines' frames.
+        struct waiter_list
+        {
+            waiter *m_head = nullptr;
+            waiter *m_tail = nullptr;
+
+            [[nodiscard]] bool empty() const noexcept { return m_head == nullptr; }
+
+            void push(waiter *w) noexcept
+            {
+                w->m_next = nullptr;
+                (m_tail ? m_tail->m_next : m_head) = w;
+                m_tail = w;
+            }
+
+            waiter *pop() noexcept
+            {
+                waiter *w = m_head;
+                m_head = w->m_next;
+                if (!m_head)
+                {
+                    m_tail = nullptr;
+                }
+                return w;
+            }
+
+            waiter *take_all() noexcept
+            {
+                m_tail = nullptr;
+                return std::exchange(m_head, nullptr);
+            }
+        };
+
+    public:
+        class send_awaitable : waiter
+        {
+        public:
+            send_awaitable(channel &channel, T value) : m_channel(channel), m_value(std::move(value)) {}
+
+            bool await_ready() const noexcept { return false; }
+
+            bool await_suspend(std::coroutine_handle<> handle)
+            {
+                this->m_handle = handle;
+                this->m_executor = executor::current();
+                return m_channel.suspend_send(*this);
+            }
+
+            // False if the channel was closed and the value was not delivered.
+            bool await_resume() const noexcept { return m_sent; }
+
+        private:
+            friend class channel;
+
+            channel &m_channel;
+            T m_value;
+            bool m_sent = false;
+        };
+
+        class recv_awaitable : waiter
+        {
+        public:
+            explicit recv_awaitable(channel &channel) noexcept : m_channel(channel) {}
+
+            bool await_ready() const noexcept { return false; }
+
+            bool await_suspend(std::coroutine_handle<> handle)
+            {
+                this->m_handle = handle;
+                this->m_executor = executor::current();
+                return m_channel.suspend_recv(*this);
+            }
+
+            // nullopt once the channel is closed and drained.
+            std::optional<T> await_resume() noexcept(std::is_nothrow_move_constructible_v<T>) { return std::move(m_value); }
+
+        private:
+            friend class channel;
+
+            channel &m_channel;
+            std::optional<T> m_value;
+        };
+
+        explicit channel(size_t capacity) : m_capacity(capacity) {}
+
+        channel(const channel &) = delete;
+        channel &operator=(const channel &) = delete;
+
+        [[nodiscard]] send_awaitable send(T value) { return {*this, std::move(value)}; }
+        [[nodiscard]] recv_awaitable recv() noexcept { return recv_awaitable{*this}; }
+
+        // Non-suspending variants for code outside coroutines; they fail rather than wait.
+        bool try_send(T &value)
+        {
+            std::unique_lock lock(m_mutex);
+            if (m_closed)
+            {
+                return false;
+            }
+            if (!m_receivers.empty())
+            {
+                auto *receiver = static_cast<recv_awaitable *>(m_receivers.pop());
+                receiver->m_value.emplace(std::move(value));
+                lock.unlock();
+                receiver->wake();
+                return true;
+            }
+            if (m_buffer.size() < m_capacity)
+            {
+                m_buffer.push_back(std::move(value));
+                return true;
+            }
+            return false;
+        }
+
+        std::optional<T> try_recv()
+        {
+            std::unique_lock lock(m_mutex);
+            std::optional<T> value;
+            waiter *sender = take_locked(value);
+            lock.unlock();
+            if (sender)
+            {
+                sender->wake();
+            }
+            return value;
+        }
+
+        void close()
+        {
+            waiter *receivers;
+            waiter *senders;
+            {
+                std::lock_guard lock(m_mutex);
+                if (std::exchange(m_closed, true))
+                {
+                    return;
+                }
+                // Receivers only wait on an empty buffer, so they all get nullopt.
+                receivers = m_receivers.take_all();
+                senders = m_senders.take_all();
+            }
+            wake_all(receivers);
+            wake_all(senders);
+        }
+
+        [[nodiscard]] bool closed() const
+        {
+            std::lock_guard lock(m_mutex);
+            return m_closed;
+        }
+
+        [[nodiscard]] size_t size() const
+        {
+            std::lock_guard lock(m_mutex);
+            return m_buffer.size();
+        }
+
+        [[nodiscard]] size_t capacity() const noexcept { return m_capacity; }
+
+    private:
+        static void wake_all(waiter *w)
+        {
+            while (w)
+            {
+                // The awaiter may be gone as soon as it is woken.
+                waiter *next = w->m_next;
+                w->wake();
+                w = next;
+            }
+        }
+
+        // Returns whether the sender has to stay suspended.
+        bool suspend_send(send_awaitable &sender)
+        {
+            std::unique_lock lock(m_mutex);
+            if (m_closed)
+            {
+                return false;
+            }
+            sender.m_sent = true;
+            if (!m_receivers.empty())
+            {
+                auto *receiver = static_cast<recv_awaitable *>(m_receivers.pop());
+                receiver->m_value.emplace(std::move(sender.m_value));
+                lock.unlock();
+                receiver->wake();
+                return false;
+            }
+            if (m_buffer.size() < m_capacity)
+            {
+                m_buffer.push_back(std::move(sender.m_value));
+                return false;
+            }
+            sender.m_sent = false;
+            m_senders.push(&sender);
+            return true;
+        }
+
+        bool suspend_recv(recv_awaitable &receiver)
+        {
+            std::unique_lock lock(m_mutex);
+            waiter *sender = take_locked(receiver.m_value);
+            if (receiver.m_value || m_closed)
+            {
+                lock.unlock();
+                if (sender)
+                {
+                    sender->wake();
+                }
+                return false;
+            }
+            m_receivers.push(&receiver);
+            return true;
+        }
+
+        // Takes the next value into `value` and, if that freed a slot, moves a blocked sender's value into the
+        // buffer. Returns that sender, to be woken once the lock is released.
+        waiter *take_locked(std::optional<T> &value)
+        {
+            if (!m_buffer.empty())
+            {
+                value.emplace(std::move(m_buffer.front()));
+                m_buffer.pop_front();
+                if (m_senders.empty())
+                {
+                    return nullptr;
+                }
+                auto *sender = static_cast<send_awaitable *>(m_senders.pop());
+                m_buffer.push_back(std::move(sender->m_value));
+                sender->m_sent = true;
+                return sender;
+            }
+            if (!m_senders.empty())
+            {
+                // Only with capacity 0: take straight from the sender.
+                auto *sender = static_cast<send_awaitable *>(m_senders.pop());
+                value.emplace(std::move(sender->m_value));
+                sender->m_sent = true;
+                return sender;
+            }
+            return nullptr;
+        }
+
+        const size_t m_capacity;
+        mutable std::mutex m_mutex;
+        std::deque<T> m_buffer;
+        waiter_list m_senders;
+        waiter_list m_receivers;
+        bool m_closed = false;
+    };
+}
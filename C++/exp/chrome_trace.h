@@ -0,0 +1,137 @@
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "metrics.h"
+
+namespace pot::metrics
+{
+    namespace details
+    {
+        inline void write_json_string(std::ostream &out, std::string_view text)
+        {
+            out << '"';
+            for (const char c : text)
+            {
+                switch (c)
+                {
+                case '"':
+                    out << "\\\"";
+                    break;
+                case '\\':
+                    out << "\\\\";
+                    break;
+                case '\n':
+                    out << "\\n";
+                    break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20)
+                    {
+                        out << ' ';
+                    }
+                    else
+                    {
+                        out << c;
+                    }
+                }
+            }
+            out << '"';
+        }
+    }
+
+    // Writes snapshots (typically taken periodically from one or more executors) in the Chrome trace event
+    // format, which chrome://tracing and ui.perfetto.dev both load. Every executor becomes a process and every
+    // worker a set of counter tracks over time; task latency percentiles are reported per executor.
+    inline void write_chrome_trace(std::ostream &out, std::span<const executor_snapshot> snapshots)
+    {
+        if (snapshots.empty())
+        {
+            out << "{\"traceEvents\":[]}\n";
+            return;
+        }
+
+        auto origin = snapshots.front().taken_at;
+        for (const auto &snapshot : snapshots)
+        {
+            origin = std::min(origin, snapshot.taken_at);
+        }
+
+        std::map<std::string, size_t> pids;
+        bool first_event = true;
+        auto begin_event = [&]
+        {
+            out << (first_event ? "\n" : ",\n");
+            first_event = false;
+        };
+
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        for (const auto &snapshot : snapshots)
+        {
+            const auto [it, inserted] = pids.try_emplace(snapshot.name, pids.size() + 1);
+            const size_t pid = it->second;
+            if (inserted)
+            {
+                begin_event();
+                out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"args\":{\"name\":";
+                details::write_json_string(out, snapshot.name);
+                out << "}}";
+            }
+
+            const auto ts = std::chrono::duration_cast<std::chrono::microseconds>(snapshot.taken_at - origin).count();
+            auto counter = [&](std::string_view track, auto &&write_args)
+            {
+                begin_event();
+                out << "{\"name\":";
+                details::write_json_string(out, track);
+                out << ",\"ph\":\"C\",\"pid\":" << pid << ",\"ts\":" << ts << ",\"args\":{";
+                write_args();
+                out << "}}";
+            };
+
+            auto write_worker = [&](const worker_snapshot &worker)
+            {
+                counter(worker.name + " tasks", [&]
+                        { out << "\"submitted\":" << worker.submitted << ",\"executed\":" << worker.executed
+                              << ",\"stolen\":" << worker.stolen; });
+                counter(worker.name + " parked ms", [&]
+                        { out << "\"parked\":" << std::chrono::duration<double, std::milli>(worker.parked).count(); });
+                counter(worker.name + " max queue length", [&]
+                        { out << "\"max_queue_length\":" << worker.max_queue_length; });
+            };
+
+            for (const auto &worker : snapshot.workers)
+            {
+                write_worker(worker);
+            }
+            if (snapshot.shared_queue.submitted)
+            {
+                write_worker(snapshot.shared_queue);
+            }
+            for (const auto &lane : snapshot.lanes)
+            {
+                counter(lane.name + " lane", [&]
+                        { out << "\"submitted\":" << lane.submitted << ",\"dispatched\":" << lane.dispatched
+                              << ",\"promoted\":" << lane.promoted << ",\"missed_deadlines\":" << lane.missed_deadlines
+                              << ",\"queued\":" << lane.queued; });
+                counter(lane.name + " lane wait us", [&]
+                        {
+                    using micros = std::chrono::duration<double, std::micro>;
+                    out << "\"p50\":" << micros(lane.wait.percentile(0.5)).count()
+                        << ",\"p99\":" << micros(lane.wait.percentile(0.99)).count(); });
+            }
+
+            const auto latency = snapshot.total().latency;
+            counter("task latency us", [&]
+                    {
+                using micros = std::chrono::duration<double, std::micro>;
+                out << "\"p50\":" << micros(latency.percentile(0.5)).count()
+                    << ",\"p99\":" << micros(latency.percentile(0.99)).count(); });
+        }
+        out << "\n]}\n";
+    }
+}
@@ -0,0 +1,234 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pot::details
+{
+    // Runs a few logical threads one at a time and switches between them only at schedule points, choosing the
+    // next one with a seeded PRNG. The same seed replays the same interleaving, so a race found by sweeping seeds
+    // can be replayed under a debugger.
+    //
+    // Schedule points are compiled into shared_state and the futex helpers with -DPOT_DETERMINISTIC_SCHEDULING=1
+    // (see schedule_point.h); elsewhere they cost nothing. atomic_wait/atomic_notify_all are modelled too: a waiter
+    // sleeps until it is notified, so a missed notification leaves every thread asleep. Such a lost wake-up, or a
+    // run that exceeds max_steps, is reported with its seed and trace and aborts the process.
+    class deterministic_scheduler
+    {
+    public:
+        struct result
+        {
+            uint64_t seed = 0;
+            size_t steps = 0;
+            // Which thread ran after each schedule point.
+            std::string trace{};
+        };
+
+        explicit deterministic_scheduler(uint64_t seed, size_t max_steps = 100000)
+            : m_seed(seed), m_max_steps(max_steps), m_random(seed) {}
+
+        deterministic_scheduler(const deterministic_scheduler &) = delete;
+        deterministic_scheduler &operator=(const deterministic_scheduler &) = delete;
+
+        // Runs every body to completion on its own thread under this schedule. The first exception a body throws
+        // is rethrown once all of them have finished.
+        result run(std::vector<std::function<void()>> bodies)
+        {
+            m_threads.assign(bodies.size(), thread_state{});
+            m_result = {.seed = m_seed};
+            m_exception = nullptr;
+
+            std::vector<std::thread> threads;
+            {
+                std::lock_guard lock(m_mutex);
+                m_current = pick_runnable();
+                record(m_current);
+            }
+            for (size_t id = 0; id < bodies.size(); ++id)
+            {
+                threads.emplace_back([this, id, &body = bodies[id]]
+                                     { thread_main(id, body); });
+            }
+            for (auto &thread : threads)
+            {
+                thread.join();
+            }
+
+            if (m_exception)
+            {
+                std::rethrow_exception(m_exception);
+            }
+            return m_result;
+        }
+
+        // True on a thread run by a scheduler.
+        [[nodiscard]] static bool active() noexcept { return tl_scheduler != nullptr; }
+
+        static void yield()
+        {
+            if (auto *scheduler = tl_scheduler)
+            {
+                std::unique_lock lock(scheduler->m_mutex);
+                scheduler->switch_from(lock, tl_id);
+            }
+        }
+
+        // The futex model. still_waiting is evaluated with every other thread stopped.
+        template <typename StillWaiting>
+        static void wait_on(const void *address, StillWaiting &&still_waiting)
+        {
+            auto *scheduler = tl_scheduler;
+            std::unique_lock lock(scheduler->m_mutex);
+            if (!still_waiting())
+            {
+                return;
+            }
+            scheduler->m_threads[tl_id].sleeping_on = address;
+            scheduler->switch_from(lock, tl_id);
+        }
+
+        static void notify_all(const void *address)
+        {
+            auto *scheduler = tl_scheduler;
+            std::lock_guard lock(scheduler->m_mutex);
+            for (auto &thread : scheduler->m_threads)
+            {
+                if (thread.sleeping_on == address)
+                {
+                    thread.sleeping_on = nullptr;
+                }
+            }
+        }
+
+    private:
+        static constexpr size_t none = std::numeric_limits<size_t>::max();
+
+        struct thread_state
+        {
+            const void *sleeping_on = nullptr;
+            bool finished = false;
+
+            [[nodiscard]] bool runnable() const noexcept { return !finished && !sleeping_on; }
+        };
+
+        void thread_main(size_t id, std::function<void()> &body)
+        {
+            tl_scheduler = this;
+            tl_id = id;
+            {
+                std::unique_lock lock(m_mutex);
+                m_turn.wait(lock, [&]
+                            { return m_current == id; });
+            }
+
+            try
+            {
+                body();
+            }
+            catch (...)
+            {
+                std::lock_guard lock(m_mutex);
+                if (!m_exception)
+                {
+                    m_exception = std::current_exception();
+                }
+            }
+
+            std::unique_lock lock(m_mutex);
+            m_threads[id].finished = true;
+            switch_from(lock, id);
+            tl_scheduler = nullptr;
+        }
+
+        // Hands the turn to a random runnable thread (possibly `id` again) and waits until `id` gets it back.
+        void switch_from(std::unique_lock<std::mutex> &lock, size_t id)
+        {
+            m_current = pick_runnable();
+            if (m_current == none)
+            {
+                bool all_finished = true;
+                for (const auto &thread : m_threads)
+                {
+                    all_finished = all_finished && thread.finished;
+                }
+                if (!all_finished)
+                {
+                    fail("every thread is waiting: lost wake-up");
+                }
+                m_turn.notify_all();
+                return;
+            }
+
+            record(m_current);
+            if (++m_result.steps > m_max_steps)
+            {
+                fail("step limit exceeded: livelock or unbounded spin");
+            }
+            m_turn.notify_all();
+            if (!m_threads[id].finished)
+            {
+                m_turn.wait(lock, [&]
+                            { return m_current == id; });
+            }
+        }
+
+        size_t pick_runnable()
+        {
+            size_t runnable = 0;
+            for (const auto &thread : m_threads)
+            {
+                runnable += thread.runnable() ? 1 : 0;
+            }
+            if (runnable == 0)
+            {
+                return none;
+            }
+
+            size_t choice = std::uniform_int_distribution<size_t>(0, runnable - 1)(m_random);
+            for (size_t id = 0; id < m_threads.size(); ++id)
+            {
+                if (m_threads[id].runnable() && choice-- == 0)
+                {
+                    return id;
+                }
+            }
+            return none;
+        }
+
+        void record(size_t id)
+        {
+            m_result.trace.push_back(static_cast<char>(id < 10 ? '0' + id : 'a' + (id - 10)));
+        }
+
+        [[noreturn]] void fail(const char *what) const
+        {
+            std::fprintf(stderr, "deterministic_scheduler: %s (seed %llu, %zu steps)\ntrace: %s\n", what,
+                         static_cast<unsigned long long>(m_seed), m_result.steps, m_result.trace.c_str());
+            std::abort();
+        }
+
+        uint64_t m_seed;
+        size_t m_max_steps;
+        std::mt19937_64 m_random;
+
+        std::mutex m_mutex;
+        std::condition_variable m_turn;
+        std::vector<thread_state> m_threads;
+        size_t m_current = none;
+        result m_result;
+        std::exception_ptr m_exception;
+
+        static inline thread_local deterministic_scheduler *tl_scheduler = nullptr;
+        static inline thread_local size_t tl_id = 0;
+    };
+}
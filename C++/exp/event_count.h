@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace pot::details
+{
+    // Eventcount: lets a consumer sleep on "no work" without a lock, and lets producers skip
+    // the wake-up entirely while nobody sleeps. Consumers follow the pattern
+    //
+    //     auto key = event.prepare_wait();
+    //     if (work_available()) event.cancel_wait(); else event.wait(key);
+    //
+    // and producers publish their work before calling notify_one()/notify_all().
+    class event_count
+    {
+    public:
+        using key_type = uint32_t;
+
+        [[nodiscard]] key_type prepare_wait() noexcept
+        {
+            m_waiters.fetch_add(1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            return m_epoch.load(std::memory_order_acquire);
+        }
+
+        void cancel_wait() noexcept
+        {
+            m_waiters.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        void wait(key_type key) noexcept
+        {
+            m_epoch.wait(key, std::memory_order_acquire);
+            m_waiters.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        void notify_one() noexcept
+        {
+            if (has_waiters())
+            {
+                m_epoch.fetch_add(1, std::memory_order_release);
+                m_epoch.notify_one();
+            }
+        }
+
+        void notify_all() noexcept
+        {
+            if (has_waiters())
+            {
+                m_epoch.fetch_add(1, std::memory_order_release);
+                m_epoch.notify_all();
+            }
+        }
+
+        // Wakes at most count sleepers, e.g. one per job of a batch, with a single epoch bump.
+        void notify_n(size_t count) noexcept
+        {
+            if (count == 0 || !has_waiters())
+            {
+                return;
+            }
+
+            const uint32_t waiters = m_waiters.load(std::memory_order_relaxed);
+            m_epoch.fetch_add(1, std::memory_order_release);
+            if (count >= waiters)
+            {
+                m_epoch.notify_all();
+                return;
+            }
+            for (size_t i = 0; i < count; ++i)
+            {
+                m_epoch.notify_one();
+            }
+        }
+
+        [[nodiscard]] uint32_t waiters() const noexcept
+        {
+            return m_waiters.load(std::memory_order_relaxed);
+        }
+
+    private:
+        bool has_waiters() const noexcept
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            return m_waiters.load(std::memory_order_relaxed) != 0;
+        }
+
+        std::atomic<key_type> m_epoch{0};
+        std::atomic<uint32_t> m_waiters{0};
+    };
+}
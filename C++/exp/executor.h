@@ -1,10 +1,97 @@
 #pragma once
 
 #include <string>
+#include <optional>
 #include <future>
 #include <functional>
+#include <coroutine>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <vector>
 
 #include "task_coroutine.h"
+#include "unique_function.h"
+#include "cancellation.h"
+#include "metrics.h"
+#include "schedule_hint.h"
+#include "thread.h"
+#include "timer_wheel.h"
+
+namespace pot::details
+{
+    // Joins the jobs of one run_bulk() call. Each job and the joining task hold a reference, so the jobs may
+    // outlive a task that was dropped without being awaited.
+    template <typename Func>
+    class bulk_state
+    {
+    public:
+        explicit bulk_state(Func func) : m_func(std::move(func)) {}
+
+        // Called once, before any job can run.
+        void expect(size_t count)
+        {
+            m_remaining.store(count, std::memory_order_relaxed);
+            if (count == 0)
+            {
+                m_done.store_value();
+                m_done.complete();
+            }
+        }
+
+        template <typename Element>
+        void run(Element &element)
+        {
+            if (!m_failed.load(std::memory_order_relaxed))
+            {
+                try
+                {
+                    std::invoke(m_func, element);
+                }
+                catch (...)
+                {
+                    if (!m_failed.exchange(true, std::memory_order_relaxed))
+                    {
+                        m_exception = std::current_exception();
+                    }
+                }
+            }
+
+            if (m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                if (m_failed.load(std::memory_order_relaxed))
+                {
+                    m_done.store_exception(m_exception);
+                }
+                else
+                {
+                    m_done.store_value();
+                }
+                m_done.complete().resume();
+            }
+        }
+
+        auto join() noexcept
+        {
+            struct awaiter
+            {
+                tasks::details::shared_state<void> &m_done;
+
+                bool await_ready() const noexcept { return m_done.is_ready(); }
+                bool await_suspend(std::coroutine_handle<> continuation) { return m_done.set_continuation(continuation); }
+                void await_resume() { m_done.get(); }
+            };
+            return awaiter{m_done};
+        }
+
+    private:
+        Func m_func;
+        std::atomic<size_t> m_remaining{0};
+        std::atomic<bool> m_failed{false};
+        std::exception_ptr m_exception;
+        tasks::details::shared_state<void> m_done;
+    };
+}
 
 namespace pot
 {
@@ -17,7 +104,40 @@ namespace pot
     protected:
         std::string m_name;
 
-        virtual void derived_execute(std::function<void()> func) = 0;
+        virtual void derived_execute(details::unique_function<void()> func) = 0;
+
+        // Queues a whole batch; executors that can do it with fewer queue operations and wake-ups override this.
+        // first_worker asks executors that deal a batch out across workers to start at that worker.
+        virtual void derived_execute_bulk(std::span<details::unique_function<void()>> funcs,
+                                          std::optional<size_t> /*first_worker*/)
+        {
+            for (auto &func : funcs)
+            {
+                derived_execute(std::move(func));
+            }
+        }
+
+        virtual void derived_execute_with(details::unique_function<void()> func, const schedule_hint &)
+        {
+            derived_execute(std::move(func));
+        }
+
+        // Executors call this first in shutdown(), so no timer resumes a coroutine onto stopped workers.
+        void stop_timers() { m_timers.stop(); }
+
+        // For executors without workers of their own: current() reports `owner` on this thread while it lives.
+        class current_scope
+        {
+        public:
+            explicit current_scope(executor *owner) noexcept : m_previous(std::exchange(tl_current_executor, owner)) {}
+            ~current_scope() { tl_current_executor = m_previous; }
+
+            current_scope(const current_scope &) = delete;
+            current_scope &operator=(const current_scope &) = delete;
+
+        private:
+            executor *m_previous;
+        };
 
     public:
         explicit executor(std::string name) : m_name(std::move(name)) {}
@@ -30,75 +150,249 @@ namespace pot
 
         [[nodiscard]] std::string name() const { return m_name; }
 
+        // The executor whose worker is running the calling thread, or nullptr.
+        [[nodiscard]] static executor *current() noexcept
+        {
+            if (tl_current_executor)
+            {
+                return tl_current_executor;
+            }
+            auto *worker = thread::current();
+            return worker ? worker->owner() : nullptr;
+        }
+
+        // Timers whose callbacks hand work to this executor; its thread starts with the first timer.
+        [[nodiscard]] details::timer_service &timers() noexcept { return m_timers; }
+
+        struct schedule_awaitable
+        {
+            executor &m_executor;
+            std::optional<schedule_hint> m_hint{};
+
+            bool await_ready() const noexcept { return false; }
+
+            void await_suspend(std::coroutine_handle<> handle)
+            {
+                if (m_hint)
+                {
+                    m_executor.derived_execute_with([handle]
+                                                    { handle.resume(); }, *m_hint);
+                }
+                else
+                {
+                    m_executor.derived_execute([handle]
+                                               { handle.resume(); });
+                }
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        // co_await executor.schedule() continues the coroutine on one of the executor's threads.
+        [[nodiscard]] schedule_awaitable schedule() noexcept { return {*this}; }
+        [[nodiscard]] schedule_awaitable schedule(schedule_hint hint) noexcept { return {*this, std::move(hint)}; }
+
         template <typename Func, typename... Args>
             requires std::is_invocable_v<Func, Args...>
         void run_detached(Func func, Args... args)
         {
-            derived_execute([=]()
-                            { func(args...); });
+            if constexpr (sizeof...(Args) == 0)
+            {
+                derived_execute(std::move(func));
+            }
+            else
+            {
+                derived_execute([func = std::move(func), ... args = std::move(args)]() mutable
+                                { std::invoke(func, args...); });
+            }
+        }
+
+        template <typename Func, typename... Args>
+            requires std::is_invocable_v<Func, Args...>
+        void run_detached(const schedule_hint &hint, Func func, Args... args)
+        {
+            if constexpr (sizeof...(Args) == 0)
+            {
+                derived_execute_with(std::move(func), hint);
+            }
+            else
+            {
+                derived_execute_with([func = std::move(func), ... args = std::move(args)]() mutable
+                                     { std::invoke(func, args...); }, hint);
+            }
+        }
+
+        // Dropped without running if the token is cancelled before a worker picks the job up.
+        template <typename Func, typename... Args>
+            requires std::is_invocable_v<Func, Args...>
+        void run_detached(std::stop_token token, Func func, Args... args)
+        {
+            derived_execute([token = std::move(token), func = std::move(func), ... args = std::move(args)]() mutable
+                            {
+                if (!token.stop_requested())
+                {
+                    std::invoke(func, args...);
+                } });
+        }
+
+        // Queues every callable of the range (moving them out of it) as one batch.
+        template <std::ranges::input_range Range>
+            requires std::constructible_from<details::unique_function<void()>, std::ranges::range_rvalue_reference_t<Range>>
+        void submit_batch(Range &&funcs)
+        {
+            std::vector<details::unique_function<void()>> batch;
+            if constexpr (std::ranges::sized_range<Range>)
+            {
+                batch.reserve(std::ranges::size(funcs));
+            }
+            for (auto &&func : funcs)
+            {
+                batch.emplace_back(std::move(func));
+            }
+            derived_execute_bulk(batch, std::nullopt);
+        }
+
+        // Runs func(element) for every element of the range, submitted as one batch, and returns a task that
+        // completes once all of them returned; the first exception is rethrown from it. Elements are copied into
+        // the jobs, so the range does not have to outlive the call. A pool that deals the batch out across its
+        // workers starts at first_worker when given, and at a rotating worker otherwise.
+        template <std::ranges::input_range Range, typename Func>
+            requires std::invocable<Func &, std::ranges::range_value_t<Range> &>
+        pot::coroutines::task<void> run_bulk(Range &&range, Func func, std::optional<size_t> first_worker = std::nullopt)
+        {
+            auto state = std::make_shared<details::bulk_state<Func>>(std::move(func));
+
+            std::vector<details::unique_function<void()>> batch;
+            if constexpr (std::ranges::sized_range<Range>)
+            {
+                batch.reserve(std::ranges::size(range));
+            }
+            for (auto &&element : range)
+            {
+                batch.emplace_back([state, element = std::ranges::range_value_t<Range>(element)]() mutable
+                                   { state->run(element); });
+            }
+
+            state->expect(batch.size());
+            derived_execute_bulk(batch, first_worker);
+            return join_bulk(std::move(state));
         }
 
         template <typename Func, typename... Args>
+            requires std::is_invocable_v<Func, Args...>
         auto run(Func func, Args... args)
         {
-            using return_type = std::invoke_result_t<Func, Args...>;
+            return run_with(std::nullopt, {}, std::move(func), std::move(args)...);
+        }
+
+        // Same as run(), queued according to the hint. For a task only its first step is prioritised: after
+        // that it continues wherever the things it awaits resume it.
+        template <typename Func, typename... Args>
+            requires std::is_invocable_v<Func, Args...>
+        auto run(const schedule_hint &hint, Func func, Args... args)
+        {
+            return run_with(hint, {}, std::move(func), std::move(args)...);
+        }
+
+        // Same as run(), but if the token is cancelled before a worker starts the job, func is never called and
+        // the future or task fails with operation_cancelled. A task also checks the token once it is scheduled;
+        // beyond that, func has to poll the token itself.
+        template <typename Func, typename... Args>
+            requires std::is_invocable_v<Func, Args...>
+        auto run(std::stop_token token, Func func, Args... args)
+        {
+            return run_with(std::nullopt, std::move(token), std::move(func), std::move(args)...);
+        }
 
-            using value_type = std::conditional_t<pot::traits::concepts::is_task<return_type>,
-                                                  pot::traits::task_value_type_t<return_type>,
-                                                  return_type>;
-            using promise_type = std::conditional_t<pot::traits::concepts::is_task<return_type>,
-                                                    typename return_type::promise_type,
-                                                    std::promise<value_type>>;
-            using future_type = std::conditional_t<pot::traits::concepts::is_task<return_type>,
-                                                   return_type,
-                                                   std::future<value_type>>;
+        virtual void shutdown() = 0;
 
-            auto lpromise = std::make_shared<promise_type>();
-            future_type future = lpromise->get_future();
+        [[nodiscard]] virtual size_t thread_count() const { return 1; }
+
+        // Per-worker counters and task latencies; zeroed unless built with POT_ENABLE_METRICS.
+        [[nodiscard]] virtual pot::metrics::executor_snapshot metrics() const
+        {
+            return {.name = m_name, .taken_at = std::chrono::steady_clock::now()};
+        }
 
-            auto lam = [lpromise, func = std::forward<Func>(func), args...]() mutable
+    private:
+        static inline thread_local executor *tl_current_executor = nullptr;
+
+        details::timer_service m_timers;
+
+        template <typename Func>
+        static pot::coroutines::task<void> join_bulk(std::shared_ptr<details::bulk_state<Func>> state)
+        {
+            co_await state->join();
+        }
+
+        template <typename Func, typename... Args>
+        auto run_with(std::optional<schedule_hint> hint, std::stop_token token, Func func, Args... args)
+        {
+            using return_type = std::invoke_result_t<Func, Args...>;
+
+            if constexpr (pot::traits::concepts::is_task<return_type>)
             {
-                try
-                {
-                    if constexpr (pot::traits::concepts::is_task<return_type>)
-                    {
-                        if constexpr (std::is_void_v<value_type>)
-                        {
-                            func(args...).get();
-                            lpromise->set_value();
-                        }
-                        else
-                        {
-                            value_type result = func(args...).get();
-                            lpromise->set_value(std::move(result));
-                        }
-                    }
-                    else
+                // The returned task is the trampoline's own frame, so no separate promise has to be shared with the job.
+                // Starting it here only gets it as far as schedule(), which hands it to a worker.
+                auto task = run_task(*this, std::move(hint), std::move(token), std::move(func), std::move(args)...);
+                task.start();
+                return task;
+            }
+            else
+            {
+                std::promise<return_type> promise(std::allocator_arg, details::pool_allocator<std::byte>{});
+                std::future<return_type> future = promise.get_future();
+
+                details::unique_function<void()> job([promise = std::move(promise), token = std::move(token),
+                                                      func = std::move(func), ... args = std::move(args)]() mutable
+                                                     {
+                    try
                     {
-                        if constexpr (std::is_void_v<value_type>)
+                        throw_if_cancelled(token);
+                        if constexpr (std::is_void_v<return_type>)
                         {
                             std::invoke(func, args...);
-                            lpromise->set_value();
+                            promise.set_value();
                         }
                         else
                         {
-                            value_type res = std::invoke(func, args...);
-                            lpromise->set_value(std::move(res));
+                            promise.set_value(std::invoke(func, args...));
                         }
                     }
+                    catch (...)
+                    {
+                        promise.set_exception(std::current_exception());
+                    } });
+                if (hint)
+                {
+                    derived_execute_with(std::move(job), *hint);
                 }
-                catch (...)
+                else
                 {
-                    lpromise->set_exception(std::current_exception());
+                    derived_execute(std::move(job));
                 }
-            };
+                return future;
+            }
+        }
 
-            derived_execute(std::move(lam));
-            return future;
+        template <typename Func, typename... Args>
+        static std::invoke_result_t<Func, Args...> run_task(executor &executor, std::optional<schedule_hint> hint,
+                                                            std::stop_token token, Func func, Args... args)
+        {
+            co_await schedule_awaitable{executor, std::move(hint)};
+            throw_if_cancelled(token);
+            co_return co_await std::invoke(func, args...);
         }
+    };
 
-        virtual void shutdown() = 0;
+    // co_await pot::schedule_on(pool) moves the rest of the coroutine onto one of pool's threads.
+    [[nodiscard]] inline executor::schedule_awaitable schedule_on(executor &executor) noexcept
+    {
+        return executor.schedule();
+    }
 
-        [[nodiscard]] virtual size_t thread_count() const { return 1; }
-    };
+    [[nodiscard]] inline executor::schedule_awaitable schedule_on(executor &executor, schedule_hint hint) noexcept
+    {
+        return executor.schedule(std::move(hint));
+    }
 }
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <type_traits>
+
+#include "executor.h"
+
+namespace pot::algorithms
+{
+    // Linux places a page on the NUMA node of the thread that first writes it. These helpers do that first write
+    // from the pool, in the chunks parfor(executor, 0, size, ...) would use, dealt out starting at worker 0. On a
+    // pinned local-queue pool (thread_pool_options::pinning) a later executor.run_bulk(..., 0) over the same chunks
+    // then runs each chunk on the worker whose node holds its pages, as long as nothing gets stolen in between.
+    template <typename T>
+        requires std::is_trivially_copyable_v<T>
+    pot::coroutines::task<void> first_touch_fill(pot::executor &executor, std::span<T> data, T value = {})
+    {
+        if (data.empty())
+        {
+            co_return;
+        }
+        const size_t chunk_size = std::max<size_t>(1, data.size() / executor.thread_count());
+        const size_t chunks = (data.size() + chunk_size - 1) / chunk_size;
+        auto fill = executor.run_bulk(std::views::iota(size_t(0), chunks), [data, value, chunk_size](size_t chunk)
+                                      { std::ranges::fill(data.subspan(chunk * chunk_size, std::min(chunk_size, data.size() - chunk * chunk_size)), value); }, 0);
+        co_await fill;
+    }
+
+    // Allocates without touching the memory (large allocations come straight from mmap), then first-touches it.
+    template <typename T>
+        requires std::is_trivially_copyable_v<T> && std::is_trivially_default_constructible_v<T>
+    pot::coroutines::task<std::unique_ptr<T[]>> first_touch_array(pot::executor &executor, size_t size, T value = {})
+    {
+        auto data = std::make_unique_for_overwrite<T[]>(size);
+        co_await first_touch_fill(executor, std::span<T>(data.get(), size), value);
+        co_return data;
+    }
+}
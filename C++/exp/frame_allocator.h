@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+
+#include "small_object_pool.h"
+
+namespace pot::details
+{
+    // Promise base that takes coroutine frames from the thread-local small_object_pool instead of the global heap,
+    // so a task that completes and is destroyed hands its frame straight to the next one.
+    //
+    // A coroutine can bring its own allocator (an arena, a std::pmr::polymorphic_allocator, ...) by taking
+    // std::allocator_arg and the allocator as its first two parameters, or as the first two after the object
+    // for member functions and lambdas:
+    //
+    //     task<int> parse(std::allocator_arg_t, std::pmr::polymorphic_allocator<> alloc, std::string_view text);
+    //
+    // A copy of the allocator is kept behind the frame and used to free it, so it may be stateful; whatever it
+    // allocates from has to outlive the frame.
+    class pooled_frame
+    {
+    public:
+        static void *operator new(std::size_t size)
+        {
+            void *frame = small_object_pool::allocate(pooled_size(size));
+            ::new (deleter_slot(frame, size)) frame_deleter(&deallocate_pooled);
+            return frame;
+        }
+
+        template <typename Alloc, typename... Args>
+        static void *operator new(std::size_t size, std::allocator_arg_t, const Alloc &alloc, const Args &...)
+        {
+            return allocate_with(size, alloc);
+        }
+
+        template <typename This, typename Alloc, typename... Args>
+        static void *operator new(std::size_t size, const This &, std::allocator_arg_t, const Alloc &alloc, const Args &...)
+        {
+            return allocate_with(size, alloc);
+        }
+
+        static void operator delete(void *frame, std::size_t size) noexcept
+        {
+            (*std::launder(static_cast<frame_deleter *>(deleter_slot(frame, size))))(frame, size);
+        }
+
+    private:
+        using frame_deleter = void (*)(void *, std::size_t) noexcept;
+
+        // Unit in which custom allocators are asked for frames, so that they come back suitably aligned.
+        struct alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) frame_block
+        {
+            std::byte m_bytes[__STDCPP_DEFAULT_NEW_ALIGNMENT__];
+        };
+
+        static constexpr std::size_t align_up(std::size_t size, std::size_t alignment) noexcept
+        {
+            return (size + alignment - 1) / alignment * alignment;
+        }
+
+        static constexpr std::size_t deleter_offset(std::size_t size) noexcept
+        {
+            return align_up(size, alignof(frame_deleter));
+        }
+
+        static constexpr std::size_t pooled_size(std::size_t size) noexcept
+        {
+            return deleter_offset(size) + sizeof(frame_deleter);
+        }
+
+        template <typename BlockAlloc>
+        static constexpr std::size_t allocator_offset(std::size_t size) noexcept
+        {
+            return align_up(pooled_size(size), alignof(BlockAlloc));
+        }
+
+        template <typename BlockAlloc>
+        static constexpr std::size_t block_count(std::size_t size) noexcept
+        {
+            return (allocator_offset<BlockAlloc>(size) + sizeof(BlockAlloc) + sizeof(frame_block) - 1) / sizeof(frame_block);
+        }
+
+        static void *deleter_slot(void *frame, std::size_t size) noexcept
+        {
+            return static_cast<std::byte *>(frame) + deleter_offset(size);
+        }
+
+        static void deallocate_pooled(void *frame, std::size_t size) noexcept
+        {
+            small_object_pool::deallocate(frame, pooled_size(size));
+        }
+
+        template <typename Alloc>
+        static void *allocate_with(std::size_t size, const Alloc &alloc)
+        {
+            using block_alloc = typename std::allocator_traits<Alloc>::template rebind_alloc<frame_block>;
+            using traits = std::allocator_traits<block_alloc>;
+
+            block_alloc allocator(alloc);
+            void *frame = traits::allocate(allocator, block_count<block_alloc>(size));
+            ::new (deleter_slot(frame, size)) frame_deleter(&deallocate_with<block_alloc>);
+            ::new (static_cast<std::byte *>(frame) + allocator_offset<block_alloc>(size)) block_alloc(std::move(allocator));
+            return frame;
+        }
+
+        template <typename BlockAlloc>
+        static void deallocate_with(void *frame, std::size_t size) noexcept
+        {
+            using traits = std::allocator_traits<BlockAlloc>;
+
+            auto *stored = std::launder(reinterpret_cast<BlockAlloc *>(static_cast<std::byte *>(frame) + allocator_offset<BlockAlloc>(size)));
+            BlockAlloc allocator(std::move(*stored));
+            stored->~BlockAlloc();
+            traits::deallocate(allocator, static_cast<frame_block *>(frame), block_count<BlockAlloc>(size));
+        }
+    };
+}
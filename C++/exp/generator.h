@@ -0,0 +1,318 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "frame_allocator.h"
+
+namespace pot::details
+{
+    // What generator<T> and async_generator<T> hand out: T& for a value type, T itself for a reference type.
+    template <typename T>
+    using yielded_reference_t = std::conditional_t<std::is_reference_v<T>, T, T &>;
+
+    // Both generators yield by address: `co_yield expr` keeps expr (a local or the temporary of the
+    // full-expression) alive across the suspension, so the consumer reads it in place without a copy.
+    template <typename T>
+    class basic_generator_promise : public pooled_frame
+    {
+    public:
+        using value_type = std::remove_cvref_t<T>;
+        using reference = yielded_reference_t<T>;
+        using pointer = std::add_pointer_t<reference>;
+
+        void return_void() noexcept {}
+
+        void unhandled_exception() noexcept
+        {
+            m_exception = std::current_exception();
+        }
+
+        [[nodiscard]] reference value() const noexcept
+        {
+            return static_cast<reference>(*m_value);
+        }
+
+        void rethrow_if_exception()
+        {
+            if (m_exception)
+            {
+                std::rethrow_exception(std::exchange(m_exception, nullptr));
+            }
+        }
+
+    protected:
+        pointer m_value = nullptr;
+        std::exception_ptr m_exception;
+    };
+}
+
+namespace pot::coroutines
+{
+    // A synchronous, lazy sequence: the body runs on the consumer's thread, one step per ++it, and cannot
+    // co_await. Use it as an input range:
+    //
+    //     generator<const record &> read(std::istream &in) { record r; while (in >> r) co_yield r; }
+    //     for (const record &r : read(in)) ...
+    template <typename T>
+    class [[nodiscard]] generator
+    {
+    public:
+        struct promise_type : public details::basic_generator_promise<T>
+        {
+            using typename details::basic_generator_promise<T>::reference;
+
+            generator get_return_object() noexcept
+            {
+                return generator{std::coroutine_handle<promise_type>::from_promise(*this)};
+            }
+
+            static constexpr std::suspend_always initial_suspend() noexcept { return {}; }
+            static constexpr std::suspend_always final_suspend() noexcept { return {}; }
+
+            std::suspend_always yield_value(std::remove_reference_t<reference> &value) noexcept
+            {
+                this->m_value = std::addressof(value);
+                return {};
+            }
+
+            std::suspend_always yield_value(std::remove_reference_t<reference> &&value) noexcept
+            {
+                this->m_value = std::addressof(value);
+                return {};
+            }
+
+            // Nothing resumes a generator but its consumer, so there is nobody to come back after an await.
+            template <typename U>
+            std::suspend_never await_transform(U &&) = delete;
+        };
+
+        using handle_type = std::coroutine_handle<promise_type>;
+
+        class iterator
+        {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = typename promise_type::value_type;
+            using reference = typename promise_type::reference;
+            using difference_type = std::ptrdiff_t;
+
+            iterator() noexcept = default;
+            explicit iterator(handle_type handle) noexcept : m_handle(handle) {}
+
+            reference operator*() const noexcept { return m_handle.promise().value(); }
+
+            iterator &operator++()
+            {
+                m_handle.resume();
+                if (m_handle.done())
+                {
+                    m_handle.promise().rethrow_if_exception();
+                }
+                return *this;
+            }
+
+            void operator++(int) { ++*this; }
+
+            friend bool operator==(const iterator &it, std::default_sentinel_t) noexcept
+            {
+                return !it.m_handle || it.m_handle.done();
+            }
+
+        private:
+            handle_type m_handle = nullptr;
+        };
+
+        generator() noexcept = default;
+        explicit generator(handle_type handle) noexcept : m_handle(handle) {}
+        generator(generator &&rhs) noexcept : m_handle(std::exchange(rhs.m_handle, nullptr)) {}
+
+        generator &operator=(generator &&rhs) noexcept
+        {
+            if (this != &rhs)
+            {
+                if (m_handle)
+                {
+                    m_handle.destroy();
+                }
+                m_handle = std::exchange(rhs.m_handle, nullptr);
+            }
+            return *this;
+        }
+
+        generator(const generator &) = delete;
+        generator &operator=(const generator &) = delete;
+
+        ~generator()
+        {
+            if (m_handle)
+            {
+                m_handle.destroy();
+            }
+        }
+
+        // Runs the body up to its first co_yield. A generator is single-pass: call begin() once.
+        iterator begin()
+        {
+            if (m_handle)
+            {
+                ++iterator(m_handle);
+            }
+            return iterator(m_handle);
+        }
+
+        std::default_sentinel_t end() const noexcept { return {}; }
+
+    private:
+        handle_type m_handle = nullptr;
+    };
+
+    // A lazy sequence whose body may co_await between yields (tasks, pot::sleep_for, ...). Each step is itself
+    // awaited, and control passes between consumer and producer by symmetric transfer: the consumer is suspended
+    // for as long as the producer runs, whichever thread the producer resumes on.
+    //
+    //     for (auto it = co_await gen.begin(); it != gen.end(); co_await ++it)
+    //         consume(*it);
+    template <typename T>
+    class [[nodiscard]] async_generator
+    {
+    public:
+        struct promise_type : public details::basic_generator_promise<T>
+        {
+            using typename details::basic_generator_promise<T>::reference;
+
+            // Hands control back to the consumer waiting for the next element (or for the end).
+            struct yield_awaiter
+            {
+                bool await_ready() const noexcept { return false; }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+                {
+                    return handle.promise().m_consumer;
+                }
+
+                void await_resume() const noexcept {}
+            };
+
+            async_generator get_return_object() noexcept
+            {
+                return async_generator{std::coroutine_handle<promise_type>::from_promise(*this)};
+            }
+
+            static constexpr std::suspend_always initial_suspend() noexcept { return {}; }
+            static constexpr yield_awaiter final_suspend() noexcept { return {}; }
+
+            yield_awaiter yield_value(std::remove_reference_t<reference> &value) noexcept
+            {
+                this->m_value = std::addressof(value);
+                return {};
+            }
+
+            yield_awaiter yield_value(std::remove_reference_t<reference> &&value) noexcept
+            {
+                this->m_value = std::addressof(value);
+                return {};
+            }
+
+            std::coroutine_handle<> m_consumer;
+        };
+
+        using handle_type = std::coroutine_handle<promise_type>;
+
+        class iterator;
+
+        // Resumes the producer until it yields or finishes; awaiting it gives the iterator to the new element.
+        class advance_awaitable
+        {
+        public:
+            explicit advance_awaitable(handle_type handle) noexcept : m_handle(handle) {}
+
+            bool await_ready() const noexcept { return !m_handle || m_handle.done(); }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> consumer) noexcept
+            {
+                m_handle.promise().m_consumer = consumer;
+                return m_handle;
+            }
+
+            iterator await_resume()
+            {
+                if (m_handle && m_handle.done())
+                {
+                    m_handle.promise().rethrow_if_exception();
+                }
+                return iterator(m_handle);
+            }
+
+        private:
+            handle_type m_handle;
+        };
+
+        class iterator
+        {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = typename promise_type::value_type;
+            using reference = typename promise_type::reference;
+            using difference_type = std::ptrdiff_t;
+
+            iterator() noexcept = default;
+            explicit iterator(handle_type handle) noexcept : m_handle(handle) {}
+
+            reference operator*() const noexcept { return m_handle.promise().value(); }
+
+            // co_await ++it;
+            advance_awaitable operator++() noexcept { return advance_awaitable(m_handle); }
+
+            friend bool operator==(const iterator &it, std::default_sentinel_t) noexcept
+            {
+                return !it.m_handle || it.m_handle.done();
+            }
+
+        private:
+            handle_type m_handle = nullptr;
+        };
+
+        async_generator() noexcept = default;
+        explicit async_generator(handle_type handle) noexcept : m_handle(handle) {}
+        async_generator(async_generator &&rhs) noexcept : m_handle(std::exchange(rhs.m_handle, nullptr)) {}
+
+        async_generator &operator=(async_generator &&rhs) noexcept
+        {
+            if (this != &rhs)
+            {
+                if (m_handle)
+                {
+                    m_handle.destroy();
+                }
+                m_handle = std::exchange(rhs.m_handle, nullptr);
+            }
+            return *this;
+        }
+
+        async_generator(const async_generator &) = delete;
+        async_generator &operator=(const async_generator &) = delete;
+
+        // Must not be destroyed while a begin() or ++ is being awaited.
+        ~async_generator()
+        {
+            if (m_handle)
+            {
+                m_handle.destroy();
+            }
+        }
+
+        // co_await gen.begin(); single-pass like generator.
+        advance_awaitable begin() noexcept { return advance_awaitable(m_handle); }
+
+        std::default_sentinel_t end() const noexcept { return {}; }
+
+    private:
+        handle_type m_handle = nullptr;
+    };
+}
@@ -1,22 +1,24 @@
 #pragma once
 
 #include "thread.h"
-#include <cassert>
 
 namespace pot
 {
-    class global_thread final : public thread
+    // Worker of a pool whose threads all take from one shared queue. Queue only needs try_pop() and empty(),
+    // so the same worker serves the FIFO task_queue and the priority lanes.
+    template <typename Queue>
+    class basic_global_thread final : public thread
     {
     public:
-        explicit global_thread(std::mutex &m, std::condition_variable &cv,
-                               std::queue<std::function<void()>> &tasks,
-                               const size_t id = 0, std::string thread_name = {})
-            : thread(id, std::move(thread_name)), m_mutex_ref(m), m_condition_ref(cv), m_tasks_ref(tasks)
+        explicit basic_global_thread(Queue &tasks, details::event_count &idle_event,
+                                     const size_t id = 0, std::string thread_name = {},
+                                     size_t spin_budget = default_spin_budget)
+            : thread(id, std::move(thread_name), &idle_event, spin_budget), m_tasks_ref(tasks)
         {
-            m_thread = std::jthread(&global_thread::thread_loop, this, m_stop_source.get_token());
+            m_thread = std::jthread(&basic_global_thread::thread_loop, this, m_stop_source.get_token());
         }
 
-        ~global_thread() override = default;
+        ~basic_global_thread() override = default;
 
         bool joinable() const override
         {
@@ -38,37 +40,41 @@ namespace pot
 
         void notify() override
         {
-            m_condition_ref.notify_one();
+            m_idle_event->notify_all();
         }
 
     private:
         void thread_loop(std::stop_token stop_token)
         {
-            while (!stop_token.stop_requested())
+            make_current();
+
+            while (true)
             {
-                std::function<void()> task;
+                auto task = m_tasks.try_pop();
+                if (!task)
                 {
-                    std::unique_lock lock(m_mutex_ref);
-                    m_condition_ref.wait(lock, [&]
-                                         { return stop_token.stop_requested() || !m_tasks_ref.empty(); });
-
-                    if (stop_token.stop_requested())
-                    {
-                        return;
-                    }
+                    task = m_tasks_ref.try_pop();
+                }
 
-                    assert(not m_tasks_ref.empty());
+                if (task)
+                {
+                    execute(task);
+                    continue;
+                }
 
-                    task = std::move(m_tasks_ref.front());
-                    m_tasks_ref.pop();
+                // Like local_thread, only stops once nothing is queued, so jobs submitted before shutdown still run.
+                if (stop_token.stop_requested())
+                {
+                    return;
                 }
 
-                task();
+                idle_wait(stop_token, [&]
+                          { return !m_tasks.empty() || !m_tasks_ref.empty(); });
             }
         }
 
-        std::mutex &m_mutex_ref;
-        std::condition_variable &m_condition_ref;
-        std::queue<std::function<void()>> &m_tasks_ref;
+        Queue &m_tasks_ref;
     };
+
+    using global_thread = basic_global_thread<details::task_queue>;
 }
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+
+#include "executor.h"
+
+namespace pot::executors
+{
+    // Runs every job on the submitting thread before run() returns. No threads, queues or wake-ups: what a
+    // benchmark measures on it is the framework's own overhead. Jobs that submit jobs recurse.
+    class inline_executor final : public executor
+    {
+    public:
+        explicit inline_executor(std::string name = "Inline") : executor(std::move(name)) {}
+
+        ~inline_executor() override { shutdown(); }
+
+        void shutdown() override { stop_timers(); }
+
+    protected:
+        void derived_execute(details::unique_function<void()> func) override
+        {
+            current_scope scope(this);
+            func();
+        }
+    };
+}
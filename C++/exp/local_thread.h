@@ -2,19 +2,34 @@
 
 #include "thread.h"
 #include "task_coroutine.h"
+#include "work_stealing_deque.h"
 
 namespace pot
 {
     class local_thread final : public thread
     {
     public:
-        explicit local_thread(const size_t id = 0, std::string thread_name = {})
-            : thread(id, std::move(thread_name))
+        explicit local_thread(const size_t id = 0, std::string thread_name = {},
+                              details::event_count *idle_event = nullptr,
+                              size_t spin_budget = default_spin_budget)
+            : thread(id, std::move(thread_name), idle_event, spin_budget)
         {
             m_thread = std::jthread(&local_thread::thread_loop, this, m_stop_source.get_token());
         }
 
-        ~local_thread() override = default;
+        ~local_thread() override
+        {
+            if (joinable())
+            {
+                request_stop();
+                m_idle_event->notify_all();
+                join();
+            }
+            while (auto task = m_deque.pop())
+            {
+                details::pool_delete(*task);
+            }
+        }
 
         bool joinable() const override
         {
@@ -36,73 +51,171 @@ namespace pot
 
         void notify() override
         {
-            m_condition.notify_one();
+            // Whoever wakes up can steal from this inbox, so any sleeper will do.
+            m_idle_event->notify_one();
+        }
+
+        // Victims in the order steal_task() tries them; must be set before set_other_workers() publishes the list.
+        // Defaults to the ring of workers after this one.
+        void set_steal_order(std::vector<size_t> order)
+        {
+            m_steal_order = std::move(order);
         }
 
         void set_other_workers(std::vector<std::unique_ptr<local_thread>> *other_workers)
         {
-            m_other_workers = other_workers;
+            if (m_steal_order.empty())
+            {
+                for (size_t i = 1; i < other_workers->size(); ++i)
+                {
+                    m_steal_order.push_back((m_id + i) % other_workers->size());
+                }
+            }
+            m_other_workers.store(other_workers, std::memory_order_release);
+        }
+
+        // Tasks submitted by the worker itself go to its lock-free deque, everything else to the locked inbox.
+        void submit(details::unique_function<void()> func)
+        {
+            if (tl_current == this)
+            {
+                m_deque.push(details::pool_new<details::unique_function<void()>>(std::move(func)));
+                m_metrics.on_submitted(m_deque.size() + m_tasks.size());
+                m_idle_event->notify_one();
+            }
+            else
+            {
+                run_detached(std::move(func));
+            }
+        }
+
+        // Batch counterpart of submit(); waking workers is left to the caller, which knows the whole batch.
+        void submit_bulk(std::span<details::unique_function<void()>> funcs)
+        {
+            if (funcs.empty())
+            {
+                return;
+            }
+
+            if (tl_current == this)
+            {
+                for (auto &func : funcs)
+                {
+                    m_deque.push(details::pool_new<details::unique_function<void()>>(std::move(func)));
+                }
+                m_metrics.on_submitted(m_deque.size() + m_tasks.size(), funcs.size());
+            }
+            else
+            {
+                m_tasks.push_bulk(funcs);
+                m_metrics.on_submitted(m_tasks.size(), funcs.size());
+            }
+        }
+
+        [[nodiscard]] static local_thread *current() noexcept { return tl_current; }
+
+        [[nodiscard]] bool is_worker_of(const std::vector<std::unique_ptr<local_thread>> *workers) const noexcept
+        {
+            return m_other_workers.load(std::memory_order_relaxed) == workers;
         }
 
     private:
         void thread_loop(std::stop_token stop_token)
         {
-            while (!stop_token.stop_requested())
+            tl_current = this;
+            make_current();
+
+            while (true)
             {
-                std::function<void()> task;
+                if (auto task = pop_task())
                 {
-                    std::unique_lock lock(m_mutex);
-                    m_condition.wait(lock, [&]
-                                     { return stop_token.stop_requested() || !m_tasks.empty(); });
-
-                    if (stop_token.stop_requested() && m_tasks.empty())
-                    {
-                        return;
-                    }
-
-                    if (!m_tasks.empty())
-                    {
-                        task = std::move(m_tasks.front());
-                        m_tasks.pop();
-                    }
+                    execute(task);
+                    continue;
                 }
 
-                if (task)
+                if (auto task = steal_task())
                 {
-                    task();
+                    m_metrics.on_stolen();
+                    execute(task);
+                    continue;
                 }
 
-                if (m_tasks.empty() && m_other_workers)
+                if (stop_token.stop_requested())
                 {
-                    task = steal_task();
-                    if (task)
-                    {
-                        task();
-                    }
+                    return;
                 }
+
+                idle_wait(stop_token, [&]
+                          { return !m_deque.empty() || !m_tasks.empty() || has_stealable_work(); });
+            }
+        }
+
+        static details::unique_function<void()> take(details::unique_function<void()> *task)
+        {
+            details::unique_function<void()> result = std::move(*task);
+            details::pool_delete(task);
+            return result;
+        }
+
+        details::unique_function<void()> pop_task()
+        {
+            if (auto task = m_deque.pop())
+            {
+                return take(*task);
             }
+            return m_tasks.try_pop();
         }
 
-        std::function<void()> steal_task()
+        details::unique_function<void()> steal_task()
         {
-            for (auto &worker : *m_other_workers)
+            auto *other_workers = m_other_workers.load(std::memory_order_acquire);
+            if (!other_workers)
+            {
+                return nullptr;
+            }
+
+            for (const size_t victim : m_steal_order)
             {
-                if (worker.get() == this)
+                if (auto task = (*other_workers)[victim]->m_deque.steal())
                 {
-                    continue;
+                    return take(*task);
                 }
+            }
 
-                std::unique_lock lock(worker->m_mutex);
-                if (!worker->m_tasks.empty())
+            // Inboxes of busy workers are only drained by their owners, so take from them as a last resort.
+            for (const size_t victim : m_steal_order)
+            {
+                if (auto task = (*other_workers)[victim]->m_tasks.try_pop())
                 {
-                    auto task = std::move(worker->m_tasks.front());
-                    worker->m_tasks.pop();
                     return task;
                 }
             }
             return nullptr;
         }
 
-        std::vector<std::unique_ptr<local_thread>> *m_other_workers{nullptr};
+        bool has_stealable_work() const
+        {
+            auto *other_workers = m_other_workers.load(std::memory_order_acquire);
+            if (!other_workers)
+            {
+                return false;
+            }
+
+            for (const size_t victim : m_steal_order)
+            {
+                const auto &worker = (*other_workers)[victim];
+                if (!worker->m_deque.empty() || !worker->m_tasks.empty())
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        static inline thread_local local_thread *tl_current = nullptr;
+
+        details::work_stealing_deque<details::unique_function<void()> *> m_deque;
+        std::atomic<std::vector<std::unique_ptr<local_thread>> *> m_other_workers{nullptr};
+        std::vector<size_t> m_steal_order;
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+
+#include "executor.h"
+
+namespace pot::executors
+{
+    // Queues jobs until the owner runs them with run_one(), run_pending() or drain(), on the owner's thread.
+    // Jobs may be submitted from any thread (timers included); they only run when driven.
+    //
+    // With a seed, run_one() takes a pseudo-random queued job instead of the oldest. Sweeping seeds then explores
+    // the orders in which independent jobs can complete, and a failing seed replays the same order.
+    class manual_executor final : public executor
+    {
+    public:
+        explicit manual_executor(std::string name = "Manual", std::optional<uint64_t> seed = std::nullopt)
+            : executor(std::move(name))
+        {
+            if (seed)
+            {
+                m_random.emplace(*seed);
+            }
+        }
+
+        ~manual_executor() override { shutdown(); }
+
+        // Drops the jobs that never ran.
+        void shutdown() override
+        {
+            stop_timers();
+            std::deque<details::unique_function<void()>> dropped;
+            std::lock_guard lock(m_mutex);
+            dropped.swap(m_tasks);
+        }
+
+        // Runs one job; false if there was none.
+        bool run_one()
+        {
+            details::unique_function<void()> task;
+            {
+                std::lock_guard lock(m_mutex);
+                if (m_tasks.empty())
+                {
+                    return false;
+                }
+                auto it = m_tasks.begin();
+                if (m_random)
+                {
+                    it += std::uniform_int_distribution<size_t>(0, m_tasks.size() - 1)(*m_random);
+                }
+                task = std::move(*it);
+                m_tasks.erase(it);
+            }
+
+            current_scope scope(this);
+            task();
+            return true;
+        }
+
+        // Runs as many jobs as were queued when it was called, leaving the ones they submit for later.
+        size_t run_pending()
+        {
+            size_t count = pending();
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (!run_one())
+                {
+                    return i;
+                }
+            }
+            return count;
+        }
+
+        // Runs jobs until the queue is empty.
+        size_t drain()
+        {
+            size_t count = 0;
+            while (run_one())
+            {
+                ++count;
+            }
+            return count;
+        }
+
+        [[nodiscard]] size_t pending() const
+        {
+            std::lock_guard lock(m_mutex);
+            return m_tasks.size();
+        }
+
+    protected:
+        void derived_execute(details::unique_function<void()> func) override
+        {
+            std::lock_guard lock(m_mutex);
+            m_tasks.push_back(std::move(func));
+        }
+
+    private:
+        mutable std::mutex m_mutex;
+        std::deque<details::unique_function<void()>> m_tasks;
+        std::optional<std::mt19937_64> m_random;
+    };
+}
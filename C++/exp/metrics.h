@@ -0,0 +1,226 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "cache_line.h"
+
+// Worker instrumentation is opt-in: build with -DPOT_ENABLE_METRICS=1. When it is off the hooks below are empty
+// inline functions on an empty member, and snapshots come back zeroed.
+#ifndef POT_ENABLE_METRICS
+#define POT_ENABLE_METRICS 0
+#endif
+
+namespace pot::metrics
+{
+    // Bucket i counts task latencies in [2^i, 2^(i+1)) nanoseconds; the last bucket takes everything above.
+    struct latency_histogram
+    {
+        static constexpr size_t bucket_count = 40;
+
+        std::array<uint64_t, bucket_count> buckets{};
+
+        static size_t bucket_of(std::chrono::nanoseconds latency) noexcept
+        {
+            const auto ns = static_cast<uint64_t>(std::max<int64_t>(latency.count(), 1));
+            return std::min<size_t>(std::bit_width(ns) - 1, bucket_count - 1);
+        }
+
+        [[nodiscard]] uint64_t count() const noexcept
+        {
+            uint64_t total = 0;
+            for (auto bucket : buckets)
+            {
+                total += bucket;
+            }
+            return total;
+        }
+
+        // Upper bound of the bucket holding the p-th quantile, p in [0, 1].
+        [[nodiscard]] std::chrono::nanoseconds percentile(double p) const noexcept
+        {
+            const uint64_t total = count();
+            if (total == 0)
+            {
+                return std::chrono::nanoseconds{0};
+            }
+
+            const auto rank = static_cast<uint64_t>(p * static_cast<double>(total - 1)) + 1;
+            uint64_t seen = 0;
+            for (size_t i = 0; i < bucket_count; ++i)
+            {
+                seen += buckets[i];
+                if (seen >= rank)
+                {
+                    return std::chrono::nanoseconds{int64_t(1) << (i + 1)};
+                }
+            }
+            return std::chrono::nanoseconds{int64_t(1) << bucket_count};
+        }
+
+        void merge(const latency_histogram &other) noexcept
+        {
+            for (size_t i = 0; i < bucket_count; ++i)
+            {
+                buckets[i] += other.buckets[i];
+            }
+        }
+    };
+
+    struct worker_snapshot
+    {
+        size_t id = 0;
+        std::string name;
+
+        uint64_t submitted = 0;
+        uint64_t executed = 0;
+        uint64_t stolen = 0;
+        std::chrono::nanoseconds parked{0};
+        uint64_t max_queue_length = 0;
+        // Time from submission until a worker started the task, for a sample of the tasks.
+        latency_histogram latency{};
+    };
+
+    // One lane of a priority_executor's queue. Always collected, since the queue takes its lock anyway.
+    struct lane_snapshot
+    {
+        std::string name;
+
+        uint64_t submitted = 0;
+        uint64_t dispatched = 0;
+        // Dispatched ahead of higher lanes because the job waited longer than the starvation threshold.
+        uint64_t promoted = 0;
+        // Deadline lane only: dispatched after its deadline had passed.
+        uint64_t missed_deadlines = 0;
+        uint64_t queued = 0;
+        uint64_t max_queue_length = 0;
+        // Time from submission until the job left the queue, for every job.
+        latency_histogram wait{};
+    };
+
+    struct executor_snapshot
+    {
+        std::string name;
+        std::chrono::steady_clock::time_point taken_at;
+        std::vector<worker_snapshot> workers{};
+        // Submissions to the queue shared by all workers (global-queue pools only).
+        worker_snapshot shared_queue{};
+        // Priority lanes, highest first, then the deadline lane (priority_executor only).
+        std::vector<lane_snapshot> lanes{};
+
+        [[nodiscard]] worker_snapshot total() const
+        {
+            worker_snapshot result{.id = workers.size(), .name = "Total"};
+            result.submitted = shared_queue.submitted;
+            result.max_queue_length = shared_queue.max_queue_length;
+            for (const auto &worker : workers)
+            {
+                result.submitted += worker.submitted;
+                result.executed += worker.executed;
+                result.stolen += worker.stolen;
+                result.parked += worker.parked;
+                result.max_queue_length = std::max(result.max_queue_length, worker.max_queue_length);
+                result.latency.merge(worker.latency);
+            }
+            return result;
+        }
+    };
+}
+
+namespace pot::details
+{
+    using metrics_clock = std::chrono::steady_clock;
+
+#if POT_ENABLE_METRICS
+    // One per worker, on its own cache lines. Only submissions may come from other threads; everything else is
+    // written by the owning worker alone, so those counters use plain load/store instead of read-modify-write.
+    class alignas(cache_line_size) worker_metrics
+    {
+    public:
+        static constexpr bool enabled = true;
+
+        void on_submitted(size_t queue_length, size_t count = 1) noexcept
+        {
+            m_submitted.fetch_add(count, std::memory_order_relaxed);
+            uint64_t current = m_max_queue_length.load(std::memory_order_relaxed);
+            while (queue_length > current &&
+                   !m_max_queue_length.compare_exchange_weak(current, queue_length, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        void on_executed() noexcept { bump(m_executed, 1); }
+        void on_stolen() noexcept { bump(m_stolen, 1); }
+        void on_parked(std::chrono::nanoseconds duration) noexcept { bump(m_parked_ns, static_cast<uint64_t>(duration.count())); }
+
+        void on_started(metrics_clock::time_point submitted_at) noexcept
+        {
+            bump(m_latency[metrics::latency_histogram::bucket_of(metrics_clock::now() - submitted_at)], 1);
+        }
+
+        void fill(metrics::worker_snapshot &snapshot) const noexcept
+        {
+            snapshot.submitted = m_submitted.load(std::memory_order_relaxed);
+            snapshot.executed = m_executed.load(std::memory_order_relaxed);
+            snapshot.stolen = m_stolen.load(std::memory_order_relaxed);
+            snapshot.parked = std::chrono::nanoseconds(m_parked_ns.load(std::memory_order_relaxed));
+            snapshot.max_queue_length = m_max_queue_length.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < metrics::latency_histogram::bucket_count; ++i)
+            {
+                snapshot.latency.buckets[i] = m_latency[i].load(std::memory_order_relaxed);
+            }
+        }
+
+        // Stamping a task costs two clock reads and, since the stamped wrapper no longer fits a unique_function's
+        // inline buffer, an allocation; so only every latency_sample_period-th submission per thread is measured.
+        static constexpr uint32_t latency_sample_period = 64;
+
+        static bool sample_latency() noexcept { return ++tl_submissions % latency_sample_period == 0; }
+
+        // The metrics of the worker running on this thread, if any; task latency is recorded there.
+        static worker_metrics *current() noexcept { return tl_current; }
+        void make_current() noexcept { tl_current = this; }
+
+    private:
+        static void bump(std::atomic<uint64_t> &counter, uint64_t amount) noexcept
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+        }
+
+        static inline thread_local worker_metrics *tl_current = nullptr;
+        static inline thread_local uint32_t tl_submissions = 0;
+
+        // Touched by submitters on other threads, kept away from the owner's counters.
+        std::atomic<uint64_t> m_submitted{0};
+        std::atomic<uint64_t> m_max_queue_length{0};
+
+        alignas(cache_line_size) std::atomic<uint64_t> m_executed{0};
+        std::atomic<uint64_t> m_stolen{0};
+        std::atomic<uint64_t> m_parked_ns{0};
+        std::array<std::atomic<uint64_t>, metrics::latency_histogram::bucket_count> m_latency{};
+    };
+#else
+    class worker_metrics
+    {
+    public:
+        static constexpr bool enabled = false;
+
+        void on_submitted(size_t, size_t = 1) noexcept {}
+        void on_executed() noexcept {}
+        void on_stolen() noexcept {}
+        void on_parked(std::chrono::nanoseconds) noexcept {}
+        void on_started(metrics_clock::time_point) noexcept {}
+        void fill(metrics::worker_snapshot &) const noexcept {}
+
+        static constexpr bool sample_latency() noexcept { return false; }
+        static worker_metrics *current() noexcept { return nullptr; }
+        void make_current() noexcept {}
+    };
+#endif
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <memory>
+
+#include "executor.h"
+
+namespace pot::algorithms
+{
+    struct parallel_for_options
+    {
+        // Iterations run between two split checks, and the smallest range that is still split.
+        // 0 picks one from the range size and the executor's thread count.
+        size_t grain_size = 0;
+    };
+}
+
+namespace pot::details
+{
+    // Lazy binary splitting: a running range hands its upper half to the executor only when the half it
+    // published before has been picked up, i.e. some worker was hungry enough to take it. Ranges that nobody
+    // steals from run to the end without further splitting. Each range only watches its own last half, so one
+    // half waiting in a queue does not stop the other ranges from splitting.
+    template <typename IndexType, typename FuncType>
+    class parallel_for_state
+    {
+    public:
+        parallel_for_state(executor &executor, FuncType &func, IndexType from, IndexType to, size_t grain_size)
+            : m_executor(executor), m_func(func), m_from(from), m_to(to), m_grain(static_cast<IndexType>(grain_size)),
+              m_remaining(static_cast<size_t>(to - from) + 1),
+              m_claimed(std::make_unique<std::atomic<bool>[]>(max_pieces(static_cast<size_t>(to - from), grain_size))) {}
+
+        bool await_ready() const noexcept { return false; }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter)
+        {
+            m_awaiter = awaiter;
+            spawn(m_from, m_to);
+            return arrive(1);
+        }
+
+        void await_resume() const
+        {
+            if (m_failed.load(std::memory_order_relaxed))
+            {
+                std::rethrow_exception(m_exception);
+            }
+        }
+
+    private:
+        static constexpr size_t none = static_cast<size_t>(-1);
+
+        // Every piece runs at least half a grain (or its whole, smaller, range), which bounds how many there are.
+        static size_t max_pieces(size_t iterations, size_t grain_size)
+        {
+            return iterations / std::max<size_t>(1, (grain_size + 1) / 2) + 1;
+        }
+
+        // Returns the piece's slot in m_claimed, set once a worker starts it.
+        size_t spawn(IndexType begin, IndexType end)
+        {
+            const size_t piece = m_pieces.fetch_add(1, std::memory_order_relaxed);
+            m_executor.run_detached([this, begin, end, piece]
+                                    {
+                m_claimed[piece].store(true, std::memory_order_relaxed);
+                run(begin, end); });
+            return piece;
+        }
+
+        void run(IndexType begin, IndexType end)
+        {
+            size_t published = none;
+            size_t processed = 0;
+            while (begin < end)
+            {
+                if (end - begin > m_grain &&
+                    (published == none || m_claimed[published].load(std::memory_order_relaxed)))
+                {
+                    const IndexType middle = begin + (end - begin) / 2;
+                    published = spawn(middle, end);
+                    end = middle;
+                    continue;
+                }
+
+                const IndexType chunk_end = begin + std::min<IndexType>(m_grain, end - begin);
+                if (!m_failed.load(std::memory_order_relaxed))
+                {
+                    try
+                    {
+                        for (IndexType i = begin; i < chunk_end; ++i)
+                        {
+                            std::invoke(m_func, i);
+                        }
+                    }
+                    catch (...)
+                    {
+                        if (!m_failed.exchange(true, std::memory_order_relaxed))
+                        {
+                            m_exception = std::current_exception();
+                        }
+                    }
+                }
+                processed += static_cast<size_t>(chunk_end - begin);
+                begin = chunk_end;
+            }
+
+            // The awaiter may destroy this state as soon as it resumes, so nothing below may touch it.
+            arrive(processed).resume();
+        }
+
+        std::coroutine_handle<> arrive(size_t count) noexcept
+        {
+            return m_remaining.fetch_sub(count, std::memory_order_acq_rel) == count ? m_awaiter : std::noop_coroutine();
+        }
+
+        executor &m_executor;
+        FuncType &m_func;
+        const IndexType m_from;
+        const IndexType m_to;
+        const IndexType m_grain;
+
+        // Iterations not yet accounted for, plus one for the awaiter.
+        std::atomic<size_t> m_remaining;
+        // One flag per published piece, set when a worker starts it.
+        std::unique_ptr<std::atomic<bool>[]> m_claimed;
+        std::atomic<size_t> m_pieces{0};
+        std::coroutine_handle<> m_awaiter;
+
+        std::atomic<bool> m_failed{false};
+        std::exception_ptr m_exception;
+    };
+}
+
+namespace pot::algorithms
+{
+    // Runs func(i) for every i in [from, to) and completes once all of them returned. Unlike parfor the range
+    // is not cut up front: it is split on demand, so skewed per-index costs still keep every worker busy.
+    // The first exception thrown by func is rethrown; iterations not started by then are skipped.
+    template <typename IndexType, typename FuncType>
+        requires std::integral<IndexType> && std::invocable<FuncType &, IndexType>
+    pot::coroutines::task<void> parallel_for(pot::executor &executor, IndexType from, IndexType to, FuncType func,
+                                             parallel_for_options options = {})
+    {
+        if (from >= to)
+        {
+            co_return;
+        }
+
+        const size_t iterations = static_cast<size_t>(to - from);
+        const size_t grain_size = options.grain_size
+                                      ? options.grain_size
+                                      : std::max<size_t>(1, iterations / (std::max<size_t>(1, executor.thread_count()) * 64));
+
+        co_await pot::details::parallel_for_state<IndexType, FuncType>(executor, func, from, to, grain_size);
+    }
+}
@@ -0,0 +1,298 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "cache_line.h"
+#include "executor.h"
+
+namespace pot::algorithms
+{
+    struct reduce_options
+    {
+        // Elements per block, and the size up to which a range is processed sequentially on the awaiting thread.
+        // 0 picks one from the range size alone, so results do not change with the pool size.
+        size_t grain_size = 0;
+        // Combine partial results in block order, so non-associative operations (floating-point sums) give the
+        // same answer on every run. Otherwise each runner folds the blocks it happened to claim.
+        bool deterministic = false;
+    };
+}
+
+namespace pot::details
+{
+    inline constexpr size_t default_reduce_grain = 4096;
+    inline constexpr size_t max_reduce_blocks = 256;
+
+    template <typename T>
+    struct alignas(cache_line_size) padded_partial
+    {
+        std::optional<T> value;
+    };
+
+    inline size_t reduce_grain_size(size_t n, const algorithms::reduce_options &options)
+    {
+        if (options.grain_size)
+        {
+            return options.grain_size;
+        }
+        return std::max(default_reduce_grain, (n + max_reduce_blocks - 1) / max_reduce_blocks);
+    }
+
+    inline std::pair<size_t, size_t> block_bounds(size_t n, size_t blocks, size_t block)
+    {
+        return {n * block / blocks, n * (block + 1) / blocks};
+    }
+
+    // Starts `runners` jobs that claim blocks [0, blocks) one at a time and call func(runner, block) on them.
+    // The awaiter is resumed by whichever runner finishes last; the first exception is rethrown to it.
+    template <typename BlockFunc>
+    class block_runner
+    {
+    public:
+        block_runner(executor &executor, size_t blocks, size_t runners, BlockFunc &func)
+            : m_executor(executor), m_func(func), m_blocks(blocks), m_runners(runners), m_remaining(runners + 1) {}
+
+        bool await_ready() const noexcept { return false; }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter)
+        {
+            m_awaiter = awaiter;
+            for (size_t runner = 0; runner < m_runners; ++runner)
+            {
+                m_executor.run_detached([this, runner]
+                                        { run(runner); });
+            }
+            return arrive();
+        }
+
+        void await_resume() const
+        {
+            if (m_failed.load(std::memory_order_relaxed))
+            {
+                std::rethrow_exception(m_exception);
+            }
+        }
+
+    private:
+        void run(size_t runner)
+        {
+            for (size_t block = m_next_block.fetch_add(1, std::memory_order_relaxed); block < m_blocks;
+                 block = m_next_block.fetch_add(1, std::memory_order_relaxed))
+            {
+                if (m_failed.load(std::memory_order_relaxed))
+                {
+                    break;
+                }
+
+                try
+                {
+                    std::invoke(m_func, runner, block);
+                }
+                catch (...)
+                {
+                    if (!m_failed.exchange(true, std::memory_order_relaxed))
+                    {
+                        m_exception = std::current_exception();
+                    }
+                }
+            }
+
+            // The awaiter owns this object, so it must not be touched once the countdown is released.
+            arrive().resume();
+        }
+
+        std::coroutine_handle<> arrive() noexcept
+        {
+            return m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1 ? m_awaiter : std::noop_coroutine();
+        }
+
+        executor &m_executor;
+        BlockFunc &m_func;
+        const size_t m_blocks;
+        const size_t m_runners;
+
+        std::atomic<size_t> m_next_block{0};
+        std::atomic<size_t> m_remaining;
+        std::coroutine_handle<> m_awaiter;
+
+        std::atomic<bool> m_failed{false};
+        std::exception_ptr m_exception;
+    };
+
+    // Like std::reduce, the operation is taken to be associative and commutative: four independent accumulators
+    // break the dependency chain of a plain left fold. The pattern is fixed, so it stays deterministic.
+    template <typename T, typename ReduceOp, typename ElementFunc>
+    T fold_range(size_t begin, size_t end, T init, ReduceOp &reduce, ElementFunc &element)
+    {
+        if (end - begin >= 8)
+        {
+            T acc0(std::invoke(element, begin));
+            T acc1(std::invoke(element, begin + 1));
+            T acc2(std::invoke(element, begin + 2));
+            T acc3(std::invoke(element, begin + 3));
+            for (begin += 4; begin + 4 <= end; begin += 4)
+            {
+                acc0 = std::invoke(reduce, std::move(acc0), std::invoke(element, begin));
+                acc1 = std::invoke(reduce, std::move(acc1), std::invoke(element, begin + 1));
+                acc2 = std::invoke(reduce, std::move(acc2), std::invoke(element, begin + 2));
+                acc3 = std::invoke(reduce, std::move(acc3), std::invoke(element, begin + 3));
+            }
+            acc0 = std::invoke(reduce, std::move(acc0), std::move(acc1));
+            acc2 = std::invoke(reduce, std::move(acc2), std::move(acc3));
+            init = std::invoke(reduce, std::move(init), std::invoke(reduce, std::move(acc0), std::move(acc2)));
+        }
+        for (; begin < end; ++begin)
+        {
+            init = std::invoke(reduce, std::move(init), std::invoke(element, begin));
+        }
+        return init;
+    }
+
+    // Shared by every reduce flavour: element(i) yields the i-th transformed element.
+    template <typename T, typename ReduceOp, typename ElementFunc>
+    coroutines::task<T> transform_reduce_indexed(executor &executor, size_t n, T init, ReduceOp reduce, ElementFunc element,
+                                                 algorithms::reduce_options options)
+    {
+        const size_t grain = reduce_grain_size(n, options);
+        if (n <= grain)
+        {
+            co_return fold_range(0, n, std::move(init), reduce, element);
+        }
+
+        const size_t blocks = (n + grain - 1) / grain;
+        const size_t runners = std::min(blocks, std::max<size_t>(1, executor.thread_count()));
+        std::vector<padded_partial<T>> partials(options.deterministic ? blocks : runners);
+
+        auto reduce_block = [&](size_t runner, size_t block)
+        {
+            const auto [begin, end] = block_bounds(n, blocks, block);
+            T block_value = fold_range(begin + 1, end, T(std::invoke(element, begin)), reduce, element);
+
+            auto &slot = partials[options.deterministic ? block : runner].value;
+            slot = slot ? std::invoke(reduce, std::move(*slot), std::move(block_value)) : std::move(block_value);
+        };
+        co_await block_runner<decltype(reduce_block)>(executor, blocks, runners, reduce_block);
+
+        for (auto &partial : partials)
+        {
+            if (partial.value)
+            {
+                init = std::invoke(reduce, std::move(init), std::move(*partial.value));
+            }
+        }
+        co_return init;
+    }
+}
+
+namespace pot::algorithms
+{
+    template <typename Iterator, typename T, typename ReduceOp = std::plus<>>
+        requires std::random_access_iterator<Iterator>
+    pot::coroutines::task<T> parallel_reduce(pot::executor &executor, Iterator first, Iterator last, T init,
+                                             ReduceOp reduce = {}, reduce_options options = {})
+    {
+        return pot::details::transform_reduce_indexed(executor, static_cast<size_t>(last - first), std::move(init),
+                                                      std::move(reduce), [first](size_t i) -> decltype(auto)
+                                                      { return first[i]; }, options);
+    }
+
+    template <typename Iterator, typename T, typename ReduceOp, typename TransformOp>
+        requires std::random_access_iterator<Iterator> && std::invocable<TransformOp &, std::iter_reference_t<Iterator>>
+    pot::coroutines::task<T> parallel_transform_reduce(pot::executor &executor, Iterator first, Iterator last, T init,
+                                                       ReduceOp reduce, TransformOp transform, reduce_options options = {})
+    {
+        return pot::details::transform_reduce_indexed(executor, static_cast<size_t>(last - first), std::move(init),
+                                                      std::move(reduce), [first, transform = std::move(transform)](size_t i) mutable
+                                                      { return std::invoke(transform, first[i]); }, options);
+    }
+
+    // Two-range form, e.g. a dot product: reduce(init, transform(first1[i], first2[i])...).
+    template <typename Iterator1, typename Iterator2, typename T, typename ReduceOp = std::plus<>, typename TransformOp = std::multiplies<>>
+        requires std::random_access_iterator<Iterator1> && std::random_access_iterator<Iterator2>
+    pot::coroutines::task<T> parallel_transform_reduce(pot::executor &executor, Iterator1 first1, Iterator1 last1, Iterator2 first2,
+                                                       T init, ReduceOp reduce = {}, TransformOp transform = {},
+                                                       reduce_options options = {})
+    {
+        return pot::details::transform_reduce_indexed(executor, static_cast<size_t>(last1 - first1), std::move(init),
+                                                      std::move(reduce), [first1, first2, transform = std::move(transform)](size_t i) mutable
+                                                      { return std::invoke(transform, first1[i], first2[i]); }, options);
+    }
+
+    // Three passes over blocks: block totals, a sequential prefix over those totals, then each block is rescanned
+    // from its offset. The combination order is fixed by the blocks, so the result is always deterministic.
+    // d_first may equal first. Returns the end of the written output.
+    template <typename InputIterator, typename OutputIterator, typename ScanOp = std::plus<>>
+        requires std::random_access_iterator<InputIterator> && std::random_access_iterator<OutputIterator>
+    pot::coroutines::task<OutputIterator> parallel_inclusive_scan(pot::executor &executor, InputIterator first, InputIterator last,
+                                                                  OutputIterator d_first, ScanOp op = {}, reduce_options options = {})
+    {
+        using value_type = std::iter_value_t<InputIterator>;
+
+        const size_t n = static_cast<size_t>(last - first);
+        const size_t grain = pot::details::reduce_grain_size(n, options);
+        if (n <= grain)
+        {
+            co_return std::inclusive_scan(first, last, d_first, op);
+        }
+
+        const size_t blocks = (n + grain - 1) / grain;
+        const size_t runners = std::min(blocks, std::max<size_t>(1, executor.thread_count()));
+        std::vector<pot::details::padded_partial<value_type>> offsets(blocks);
+
+        // The last block's total is never needed.
+        auto sum_block = [&](size_t, size_t block)
+        {
+            const auto [begin, end] = pot::details::block_bounds(n, blocks, block);
+            value_type total = first[begin];
+            for (size_t i = begin + 1; i < end; ++i)
+            {
+                total = std::invoke(op, std::move(total), first[i]);
+            }
+            offsets[block].value = std::move(total);
+        };
+        co_await pot::details::block_runner<decltype(sum_block)>(executor, blocks - 1, runners, sum_block);
+
+        std::optional<value_type> carry;
+        for (size_t block = 0; block < blocks; ++block)
+        {
+            std::optional<value_type> total = std::exchange(offsets[block].value, carry);
+            if (block + 1 == blocks)
+            {
+                break;
+            }
+            if (carry)
+            {
+                carry = std::invoke(op, std::move(*carry), std::move(*total));
+            }
+            else
+            {
+                carry = std::move(total);
+            }
+        }
+
+        auto scan_block = [&](size_t, size_t block)
+        {
+            const auto [begin, end] = pot::details::block_bounds(n, blocks, block);
+            const auto &offset = offsets[block].value;
+            value_type running = offset ? std::invoke(op, *offset, first[begin]) : value_type(first[begin]);
+            d_first[begin] = running;
+            for (size_t i = begin + 1; i < end; ++i)
+            {
+                running = std::invoke(op, std::move(running), first[i]);
+                d_first[i] = running;
+            }
+        };
+        co_await pot::details::block_runner<decltype(scan_block)>(executor, blocks, runners, scan_block);
+
+        co_return d_first + n;
+    }
+}
@@ -2,15 +2,20 @@
 
 #include <utility>
 #include <cassert>
+#include <ranges>
+#include <stop_token>
 
 #include "thread_pool_executor.h"
 #include "when_all.h"
 
 namespace pot::algorithms
 {
+    // Once the token is cancelled, chunks that have not started are skipped, running ones stop before their next
+    // iteration, and the returned task fails with pot::operation_cancelled.
     template <int64_t static_chunk_size = -1, typename IndexType, typename FuncType = void(IndexType)>
         requires std::invocable<FuncType, IndexType>
-    pot::coroutines::task<void> parfor(pot::executor &executor, IndexType from, IndexType to, FuncType &&func)
+    pot::coroutines::task<void> parfor(pot::executor &executor, IndexType from, IndexType to, FuncType func,
+                                       std::stop_token token = {})
     {
         assert(from < to);
 
@@ -21,6 +26,31 @@ namespace pot::algorithms
             chunk_size = std::max<int64_t>(1, numIterations / executor.thread_count());
 
         const int64_t numChunks = (numIterations + chunk_size - 1) / chunk_size;
+
+        // Plain functions need no coroutine per chunk: all chunks go to the executor as one batch.
+        if constexpr (!std::is_invocable_r_v<pot::coroutines::task<void>, FuncType, IndexType>)
+        {
+            auto chunks = executor.run_bulk(std::views::iota(int64_t(0), numChunks), [from, to, chunk_size, func, token](int64_t chunkIndex)
+                                            {
+                const IndexType chunkStart = from + IndexType(chunkIndex * chunk_size);
+                const IndexType chunkEnd = std::min<IndexType>(chunkStart + IndexType(chunk_size), to);
+                if (!token.stop_possible())
+                {
+                    for (IndexType i = chunkStart; i < chunkEnd; ++i)
+                    {
+                        std::invoke(func, i);
+                    }
+                    return;
+                }
+                for (IndexType i = chunkStart; i < chunkEnd; ++i)
+                {
+                    pot::throw_if_cancelled(token);
+                    std::invoke(func, i);
+                } });
+            co_await chunks;
+            co_return;
+        }
+
         std::vector<pot::coroutines::task<void>> tasks;
         tasks.reserve(numChunks);
 
@@ -29,10 +59,11 @@ namespace pot::algorithms
             const IndexType chunkStart = from + IndexType(chunkIndex * chunk_size);
             const IndexType chunkEnd = std::min<IndexType>(chunkStart + IndexType(chunk_size), to);
 
-            tasks.push_back(executor.run([chunkStart, chunkEnd, func = std::forward<FuncType>(func)]() -> pot::coroutines::task<void>
+            tasks.push_back(executor.run(token, [chunkStart, chunkEnd, func, token]() -> pot::coroutines::task<void>
                                          {
             for (IndexType i = chunkStart; i < chunkEnd; ++i)
             {
+                pot::throw_if_cancelled(token);
                 if constexpr (std::is_invocable_r_v<pot::coroutines::task<void>, FuncType, IndexType>)
                 {
                     co_await std::invoke(func, i);
@@ -45,7 +76,14 @@ namespace pot::algorithms
             co_return; }));
         }
 
-        co_await pot::when_all(tasks.begin(), tasks.end());
+        if (token.stop_possible())
+        {
+            co_await pot::when_all(tasks.begin(), tasks.end(), token);
+        }
+        else
+        {
+            co_await pot::when_all(tasks.begin(), tasks.end());
+        }
         co_return;
     }
 }
\ No newline at end of file
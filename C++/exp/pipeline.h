@@ -0,0 +1,260 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "channel.h"
+#include "executor.h"
+#include "generator.h"
+#include "task_coroutine.h"
+#include "unique_function.h"
+#include "when_all.h"
+
+namespace pot::details
+{
+    template <typename Func, typename T>
+    struct stage_result
+    {
+        using type = std::invoke_result_t<Func &, T>;
+    };
+
+    // Stages may be coroutines; what flows on is what their task produces.
+    template <typename Func, typename T>
+        requires traits::concepts::is_task<std::invoke_result_t<Func &, T>>
+    struct stage_result<Func, T>
+    {
+        using type = traits::task_value_type_t<std::invoke_result_t<Func &, T>>;
+    };
+
+    template <typename Func, typename T>
+    using stage_result_t = typename stage_result<Func, T>::type;
+
+    // Shared by the workers of one stage. The last one to finish closes the output.
+    template <typename In, typename Out, typename Func>
+    struct pipeline_stage_state
+    {
+        std::shared_ptr<channel<In>> m_input;
+        std::shared_ptr<channel<Out>> m_output;
+        Func m_func;
+        std::atomic<size_t> m_running;
+    };
+
+    template <typename In, typename Out, typename Func>
+    coroutines::task<void> pipeline_stage_worker(std::shared_ptr<pipeline_stage_state<In, Out, Func>> state)
+    {
+        auto finish = [&]
+        {
+            if constexpr (!std::is_void_v<Out>)
+            {
+                if (state->m_running.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    state->m_output->close();
+                }
+            }
+        };
+
+        try
+        {
+            while (true)
+            {
+                auto receive = state->m_input->recv();
+                auto item = co_await receive;
+                if (!item)
+                {
+                    break;
+                }
+
+                if constexpr (traits::concepts::is_task<std::invoke_result_t<Func &, In>>)
+                {
+                    auto step = std::invoke(state->m_func, std::move(*item));
+                    if constexpr (std::is_void_v<Out>)
+                    {
+                        co_await step;
+                        continue;
+                    }
+                    else
+                    {
+                        auto send = state->m_output->send(co_await step);
+                        if (co_await send)
+                        {
+                            continue;
+                        }
+                    }
+                }
+                else if constexpr (std::is_void_v<Out>)
+                {
+                    std::invoke(state->m_func, std::move(*item));
+                    continue;
+                }
+                else
+                {
+                    auto send = state->m_output->send(std::invoke(state->m_func, std::move(*item)));
+                    if (co_await send)
+                    {
+                        continue;
+                    }
+                }
+
+                // Everything downstream has stopped: stop upstream too.
+                state->m_input->close();
+                break;
+            }
+        }
+        catch (...)
+        {
+            state->m_input->close();
+            finish();
+            throw;
+        }
+        finish();
+    }
+
+    template <typename T, typename Source>
+    coroutines::task<void> pipeline_source_worker(std::shared_ptr<channel<T>> output, std::shared_ptr<Source> source)
+    {
+        try
+        {
+            if constexpr (std::is_invocable_v<Source &>)
+            {
+                while (std::optional<T> item = std::invoke(*source))
+                {
+                    auto send = output->send(std::move(*item));
+                    if (!co_await send)
+                    {
+                        break;
+                    }
+                }
+            }
+            else
+            {
+                for (auto &&item : *source)
+                {
+                    auto send = output->send(T(std::forward<decltype(item)>(item)));
+                    if (!co_await send)
+                    {
+                        break;
+                    }
+                }
+            }
+        }
+        catch (...)
+        {
+            output->close();
+            throw;
+        }
+        output->close();
+    }
+}
+
+namespace pot
+{
+    // Chains stages over bounded channels, each stage with its own number of workers on one executor:
+    //
+    //     auto done = pot::make_pipeline(pool, read_record)
+    //                     .then(4, compute)
+    //                     .then(1, format)
+    //                     .sink(1, write);
+    //     done.get();
+    //
+    // The source is a callable returning std::optional<T> (nullopt ends the stream) or a generator<T>.
+    // Stage functions take the previous stage's value and return the next one, directly or as a task. With
+    // more than one worker a stage's function is called concurrently and items may be reordered. Workers are
+    // coroutines, so a stage waiting on a full or empty channel does not hold a thread. Nothing runs until
+    // sink(); its task completes once every item has reached the sink, and rethrows the first failure, which
+    // also shuts the pipeline down.
+    template <typename T>
+    class [[nodiscard]] pipeline
+    {
+    public:
+        static constexpr size_t default_capacity = 64;
+
+        pipeline(executor &executor, std::shared_ptr<channel<T>> tail, size_t capacity,
+                 std::vector<details::unique_function<coroutines::task<void>()>> launchers)
+            : m_executor(executor), m_tail(std::move(tail)), m_capacity(capacity), m_launchers(std::move(launchers)) {}
+
+        // Appends a stage of `parallelism` workers running func on every item.
+        template <typename Func>
+            requires std::is_invocable_v<Func &, T> && (!std::is_void_v<details::stage_result_t<Func, T>>)
+        auto then(size_t parallelism, Func func) &&
+        {
+            using out_type = std::remove_cvref_t<details::stage_result_t<Func, T>>;
+
+            auto output = std::make_shared<channel<out_type>>(m_capacity);
+            add_stage<out_type>(parallelism, std::move(func), output);
+            return pipeline<out_type>(m_executor, std::move(output), m_capacity, std::move(m_launchers));
+        }
+
+        // Output channel capacity for the stages added after this call.
+        pipeline &&with_capacity(size_t capacity) &&
+        {
+            m_capacity = capacity;
+            return std::move(*this);
+        }
+
+        // Appends the final stage and starts every worker.
+        template <typename Func>
+            requires std::is_invocable_v<Func &, T>
+        coroutines::task<void> sink(size_t parallelism, Func func) &&
+        {
+            add_stage<void>(parallelism, std::move(func), nullptr);
+
+            std::vector<coroutines::task<void>> workers;
+            for (auto &launch : m_launchers)
+            {
+                workers.push_back(launch());
+            }
+            return when_all(std::move(workers));
+        }
+
+    private:
+        template <typename Out, typename Func>
+        void add_stage(size_t parallelism, Func func, std::shared_ptr<channel<Out>> output)
+        {
+            parallelism = std::max<size_t>(parallelism, 1);
+            auto state = std::make_shared<details::pipeline_stage_state<T, Out, Func>>(m_tail, std::move(output), std::move(func), parallelism);
+            for (size_t i = 0; i < parallelism; ++i)
+            {
+                m_launchers.emplace_back([&executor = m_executor, state]
+                                         { return executor.run(details::pipeline_stage_worker<T, Out, Func>, state); });
+            }
+        }
+
+        executor &m_executor;
+        std::shared_ptr<channel<T>> m_tail;
+        size_t m_capacity;
+        std::vector<details::unique_function<coroutines::task<void>()>> m_launchers;
+    };
+
+    template <typename Source>
+        requires std::is_invocable_v<Source &>
+    auto make_pipeline(executor &executor, Source source, size_t capacity = pipeline<int>::default_capacity)
+    {
+        using value_type = typename std::invoke_result_t<Source &>::value_type;
+
+        auto output = std::make_shared<channel<value_type>>(capacity);
+        std::vector<details::unique_function<coroutines::task<void>()>> launchers;
+        launchers.emplace_back([&executor, output, source = std::make_shared<Source>(std::move(source))]
+                               { return executor.run(details::pipeline_source_worker<value_type, Source>, output, source); });
+        return pipeline<value_type>(executor, std::move(output), capacity, std::move(launchers));
+    }
+
+    template <typename T>
+    auto make_pipeline(executor &executor, coroutines::generator<T> source, size_t capacity = pipeline<int>::default_capacity)
+    {
+        using value_type = std::remove_cvref_t<T>;
+        using source_type = coroutines::generator<T>;
+
+        auto output = std::make_shared<channel<value_type>>(capacity);
+        std::vector<details::unique_function<coroutines::task<void>()>> launchers;
+        launchers.emplace_back([&executor, output, source = std::make_shared<source_type>(std::move(source))]
+                               { return executor.run(details::pipeline_source_worker<value_type, source_type>, output, source); });
+        return pipeline<value_type>(executor, std::move(output), capacity, std::move(launchers));
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "global_thread.h"
+#include "priority_task_queue.h"
+#include "executor.h"
+
+namespace pot::executors
+{
+    struct priority_executor_options
+    {
+        size_t spin_budget = pot::thread::default_spin_budget;
+
+        // A lane whose oldest job has waited this long is served before higher lanes and deadlines.
+        std::chrono::steady_clock::duration starvation_threshold = details::priority_task_queue::default_starvation_threshold;
+    };
+
+    // Shared-queue pool that honours schedule_hint: run(pot::priority::high, f) or
+    // run(pot::schedule_hint::within(2ms), f). Plain run() and run_detached() go to the normal lane.
+    class priority_executor final : public executor
+    {
+    public:
+        using thread_type = pot::basic_global_thread<details::priority_task_queue>;
+
+        explicit priority_executor(std::string name, size_t num_threads = std::thread::hardware_concurrency(),
+                                   priority_executor_options options = {})
+            : executor(std::move(name)), m_tasks(options.starvation_threshold)
+        {
+            m_threads.reserve(num_threads);
+            for (size_t i = 0; i < num_threads; ++i)
+            {
+                m_threads.push_back(std::make_unique<thread_type>(
+                    m_tasks, m_idle_event, i, "Thread " + std::to_string(i), options.spin_budget));
+                m_threads.back()->set_owner(this);
+            }
+        }
+
+        ~priority_executor() override { shutdown(); }
+
+        void shutdown() override
+        {
+            stop_timers();
+            for (auto &thread : m_threads)
+            {
+                thread->request_stop();
+            }
+
+            m_idle_event.notify_all();
+
+            for (auto &thread : m_threads)
+            {
+                if (thread->joinable())
+                {
+                    thread->join();
+                }
+            }
+        }
+
+        [[nodiscard]] size_t thread_count() const override { return m_threads.size(); }
+
+        [[nodiscard]] pot::metrics::executor_snapshot metrics() const override
+        {
+            pot::metrics::executor_snapshot snapshot{.name = m_name, .taken_at = std::chrono::steady_clock::now()};
+            snapshot.workers.reserve(m_threads.size());
+            for (const auto &thread : m_threads)
+            {
+                auto &worker = snapshot.workers.emplace_back();
+                worker.id = thread->id();
+                worker.name = thread->thread_name();
+                thread->metrics().fill(worker);
+            }
+            snapshot.lanes = m_tasks.lane_metrics();
+            return snapshot;
+        }
+
+    protected:
+        void derived_execute(details::unique_function<void()> func) override
+        {
+            m_tasks.push(std::move(func));
+            m_idle_event.notify_one();
+        }
+
+        void derived_execute_with(details::unique_function<void()> func, const schedule_hint &hint) override
+        {
+            m_tasks.push(std::move(func), hint);
+            m_idle_event.notify_one();
+        }
+
+        void derived_execute_bulk(std::span<details::unique_function<void()>> funcs, std::optional<size_t>) override
+        {
+            m_tasks.push_bulk(funcs);
+            m_idle_event.notify_n(funcs.size());
+        }
+
+    private:
+        // Declared before m_threads: the workers reference both until they are joined.
+        details::event_count m_idle_event;
+        details::priority_task_queue m_tasks;
+
+        std::vector<std::unique_ptr<thread_type>> m_threads;
+    };
+}
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <span>
+#include <vector>
+
+#include "unique_function.h"
+#include "schedule_hint.h"
+#include "metrics.h"
+
+namespace pot::details
+{
+    // One FIFO lane per priority plus a deadline lane kept as an earliest-deadline-first heap, all behind one
+    // mutex. Deadline jobs go first, then the highest non-empty lane; but a lane that has had work without being
+    // served for the starvation threshold gets its next job dispatched ahead of everything else. So under a
+    // steady stream of urgent jobs every lane still gets at least one job per threshold interval.
+    class priority_task_queue
+    {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        static constexpr std::chrono::milliseconds default_starvation_threshold{10};
+        static constexpr size_t deadline_lane = priority_count;
+        static constexpr size_t lane_count = priority_count + 1;
+
+        explicit priority_task_queue(clock::duration starvation_threshold = default_starvation_threshold)
+            : m_starvation_threshold(starvation_threshold) {}
+
+        void push(unique_function<void()> task, const schedule_hint &hint = {})
+        {
+            const auto now = clock::now();
+            std::lock_guard lock(m_mutex);
+            enqueue(std::move(task), hint, now);
+            m_size.store(m_size.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        // Moves every job in under a single lock acquisition, all with the same hint.
+        void push_bulk(std::span<unique_function<void()>> tasks, const schedule_hint &hint = {})
+        {
+            const auto now = clock::now();
+            std::lock_guard lock(m_mutex);
+            for (auto &task : tasks)
+            {
+                enqueue(std::move(task), hint, now);
+            }
+            m_size.store(m_size.load(std::memory_order_relaxed) + tasks.size(), std::memory_order_release);
+        }
+
+        unique_function<void()> try_pop()
+        {
+            if (empty())
+            {
+                return nullptr;
+            }
+
+            const auto now = clock::now();
+            std::lock_guard lock(m_mutex);
+            const size_t lane = pick_lane(now);
+            if (lane == lane_count)
+            {
+                return nullptr;
+            }
+
+            entry job;
+            if (lane == deadline_lane)
+            {
+                std::ranges::pop_heap(m_deadlines, std::greater{});
+                job = std::move(m_deadlines.back());
+                m_deadlines.pop_back();
+                if (job.deadline < now)
+                {
+                    ++m_counters[lane].missed_deadlines;
+                }
+            }
+            else
+            {
+                job = std::move(m_lanes[lane].front());
+                m_lanes[lane].pop_front();
+                m_last_served[lane] = now;
+            }
+
+            auto &counters = m_counters[lane];
+            ++counters.dispatched;
+            --counters.queued;
+            ++counters.wait.buckets[metrics::latency_histogram::bucket_of(now - job.queued_at)];
+            m_size.store(m_size.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+            return std::move(job.task);
+        }
+
+        [[nodiscard]] bool empty() const noexcept
+        {
+            return m_size.load(std::memory_order_acquire) == 0;
+        }
+
+        [[nodiscard]] size_t size() const noexcept
+        {
+            return m_size.load(std::memory_order_relaxed);
+        }
+
+        // Priority lanes, highest first, then the deadline lane.
+        [[nodiscard]] std::vector<metrics::lane_snapshot> lane_metrics() const
+        {
+            static constexpr std::array<const char *, lane_count> names{"High", "Normal", "Low", "Deadline"};
+
+            std::lock_guard lock(m_mutex);
+            std::vector<metrics::lane_snapshot> lanes(m_counters.begin(), m_counters.end());
+            for (size_t i = 0; i < lane_count; ++i)
+            {
+                lanes[i].name = names[i];
+            }
+            return lanes;
+        }
+
+    private:
+        struct entry
+        {
+            unique_function<void()> task;
+            clock::time_point queued_at;
+            clock::time_point deadline{};
+            // Keeps jobs with equal deadlines in submission order.
+            uint64_t sequence = 0;
+
+            friend bool operator>(const entry &lhs, const entry &rhs) noexcept
+            {
+                return lhs.deadline != rhs.deadline ? lhs.deadline > rhs.deadline : lhs.sequence > rhs.sequence;
+            }
+        };
+
+        void enqueue(unique_function<void()> task, const schedule_hint &hint, clock::time_point now)
+        {
+            size_t lane = static_cast<size_t>(hint.level);
+            if (hint.deadline)
+            {
+                lane = deadline_lane;
+                m_deadlines.push_back({std::move(task), now, *hint.deadline, m_sequence++});
+                std::ranges::push_heap(m_deadlines, std::greater{});
+            }
+            else
+            {
+                m_lanes[lane].push_back({std::move(task), now});
+            }
+
+            auto &counters = m_counters[lane];
+            ++counters.submitted;
+            ++counters.queued;
+            counters.max_queue_length = std::max(counters.max_queue_length, counters.queued);
+        }
+
+        size_t pick_lane(clock::time_point now)
+        {
+            size_t starved = lane_count;
+            auto oldest = now - m_starvation_threshold;
+            for (size_t lane = 0; lane < priority_count; ++lane)
+            {
+                if (m_lanes[lane].empty())
+                {
+                    continue;
+                }
+                // Waiting since the lane was last served, or since its head arrived if it ran dry in between.
+                const auto waiting_since = std::max(m_last_served[lane], m_lanes[lane].front().queued_at);
+                if (waiting_since < oldest)
+                {
+                    oldest = waiting_since;
+                    starved = lane;
+                }
+            }
+            if (starved != lane_count)
+            {
+                // Only counts when the lane was actually overtaking something.
+                if (!m_deadlines.empty() || std::any_of(m_lanes.begin(), m_lanes.begin() + static_cast<ptrdiff_t>(starved),
+                                                        [](const auto &lane)
+                                                        { return !lane.empty(); }))
+                {
+                    ++m_counters[starved].promoted;
+                }
+                return starved;
+            }
+
+            if (!m_deadlines.empty())
+            {
+                return deadline_lane;
+            }
+            for (size_t lane = 0; lane < priority_count; ++lane)
+            {
+                if (!m_lanes[lane].empty())
+                {
+                    return lane;
+                }
+            }
+            return lane_count;
+        }
+
+        clock::duration m_starvation_threshold;
+
+        mutable std::mutex m_mutex;
+        std::array<std::deque<entry>, priority_count> m_lanes;
+        std::vector<entry> m_deadlines;
+        std::array<clock::time_point, priority_count> m_last_served{};
+        uint64_t m_sequence = 0;
+        std::array<metrics::lane_snapshot, lane_count> m_counters{};
+        std::atomic_size_t m_size{0};
+    };
+}
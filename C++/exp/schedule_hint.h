@@ -0,0 +1,40 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace pot
+{
+    enum class priority : uint8_t
+    {
+        high,
+        normal,
+        low,
+    };
+
+    inline constexpr size_t priority_count = 3;
+
+    // How urgently a job should be started. Executors without priority lanes ignore it; priority_executor runs
+    // jobs with a deadline earliest-deadline-first, ahead of the lanes.
+    struct schedule_hint
+    {
+        priority level = priority::normal;
+        std::optional<std::chrono::steady_clock::time_point> deadline;
+
+        schedule_hint() = default;
+        schedule_hint(priority level) : level(level) {}
+        schedule_hint(std::chrono::steady_clock::time_point deadline, priority level = priority::normal)
+            : level(level), deadline(deadline) {}
+
+        // Due `budget` from now.
+        template <typename Rep, typename Period>
+        [[nodiscard]] static schedule_hint within(std::chrono::duration<Rep, Period> budget, priority level = priority::normal)
+        {
+            return {std::chrono::steady_clock::now() +
+                        std::chrono::ceil<std::chrono::steady_clock::duration>(budget),
+                    level};
+        }
+    };
+}
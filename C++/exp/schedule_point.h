@@ -0,0 +1,14 @@
+#pragma once
+
+// Points at which deterministic_scheduler may switch threads. They are compiled in only with
+// -DPOT_DETERMINISTIC_SCHEDULING=1; otherwise POT_SCHEDULE_POINT() expands to nothing.
+#ifndef POT_DETERMINISTIC_SCHEDULING
+#define POT_DETERMINISTIC_SCHEDULING 0
+#endif
+
+#if POT_DETERMINISTIC_SCHEDULING
+#include "deterministic_scheduler.h"
+#define POT_SCHEDULE_POINT() ::pot::details::deterministic_scheduler::yield()
+#else
+#define POT_SCHEDULE_POINT() ((void)0)
+#endif
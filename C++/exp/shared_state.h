@@ -3,14 +3,18 @@
 #include <atomic>
 #include <exception>
 #include <chrono>
+#include <coroutine>
 #include <variant>
 #include <functional>
 #include <stdexcept>
 #include <string>
-#include <vector>
 #include <algorithm>
-#include <iostream>
 #include <type_traits>
+#include <utility>
+
+#include "atomic_wait.h"
+#include "schedule_point.h"
+#include "spin_wait.h"
 
 namespace pot::tasks::details
 {
@@ -23,67 +27,98 @@ namespace pot::tasks::details
                                                 std::variant<std::monostate, std::exception_ptr>,
                                                 std::variant<std::monostate, T, std::exception_ptr>>;
 
+        // Rounds of backoff a blocking waiter spins before it sleeps on the futex.
+        static constexpr size_t wait_spin_budget = 16;
+
         shared_state() = default;
 
         shared_state(const shared_state &) = delete;
         shared_state &operator=(const shared_state &) = delete;
 
-        void set_continuation(std::coroutine_handle<> continuation)
+        // Registers the coroutine to resume on completion. Returns false, without registering, when the
+        // state has already completed (or is completing concurrently): the caller must then continue itself.
+        // Only one continuation is supported, which matches task being move-only.
+        bool set_continuation(std::coroutine_handle<> continuation)
         {
-            if (is_ready() && continuation)
+            void *expected = nullptr;
+            POT_SCHEDULE_POINT();
+            if (m_continuation.compare_exchange_strong(expected, continuation.address(),
+                                                       std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                return true;
+            }
+            if (expected != completed_marker())
             {
-                continuation.resume();
+                throw std::logic_error("shared_state already has a continuation.");
             }
-            else
+            // complete() still has to publish the ready flag; once the caller moves on it may destroy the state.
+            while (!is_ready())
             {
-                m_continuations.push_back(continuation); 
+                pot::details::cpu_relax();
             }
+            return false;
         }
 
         template <typename U = T>
         void set_value(U &&value)
             requires(!std::is_void_v<T>)
         {
-            m_data.template emplace<T>(std::forward<U>(value));
-            if (m_ready.exchange(true, std::memory_order_release))
-            {
-                throw std::runtime_error("Value already set in shared_state.");
-            }
-            for (auto &cont : m_continuations)
-            {
-                cont.resume();
-            }
-            m_continuations.clear();
+            store_value(std::forward<U>(value));
+            complete().resume();
         }
 
         void set_value()
             requires(std::is_void_v<T>)
         {
-            m_data = std::monostate{};
-            if (m_ready.exchange(true, std::memory_order_release))
-            {
-                throw std::runtime_error("Value already set in shared_state.");
-            }
-            for (auto &cont : m_continuations)
-            {
-                cont.resume();
-            }
-            m_continuations.clear();
+            store_value();
+            complete().resume();
         }
 
         void set_exception(std::exception_ptr ex)
+        {
+            store_exception(ex);
+            complete().resume();
+        }
+
+        // store_*() only record the result; complete() publishes it and hands back the continuation
+        // instead of resuming it, so a coroutine can transfer to it from its final suspend point.
+        template <typename U = T>
+        void store_value(U &&value)
+            requires(!std::is_void_v<T>)
+        {
+            m_data.template emplace<T>(std::forward<U>(value));
+        }
+
+        void store_value()
+            requires(std::is_void_v<T>)
+        {
+            m_data = std::monostate{};
+        }
+
+        void store_exception(std::exception_ptr ex)
         {
             m_data = ex;
-            printf("Rethrow\n");
-            if (m_ready.exchange(true, std::memory_order_release))
+        }
+
+        // Once this returns, a waiter may already have destroyed the state, so callers must not touch it afterwards.
+        std::coroutine_handle<> complete()
+        {
+            POT_SCHEDULE_POINT();
+            void *continuation = m_continuation.exchange(completed_marker(), std::memory_order_acq_rel);
+
+            POT_SCHEDULE_POINT();
+            const uint32_t previous = m_flags.exchange(ready_flag, std::memory_order_acq_rel);
+            if (previous & ready_flag)
             {
-                throw std::runtime_error("Exception already set in shared_state.");
+                throw std::runtime_error("Result already set in shared_state.");
             }
-            for (auto &cont : m_continuations)
+            // Only pay for the syscall when a blocking waiter went to sleep.
+            if (previous & waiters_flag)
             {
-                cont.resume();
+                pot::details::atomic_notify_all(m_flags);
             }
-            m_continuations.clear();
+
+            return continuation ? std::coroutine_handle<>::from_address(continuation) : std::noop_coroutine();
         }
 
         T get()
@@ -93,29 +128,111 @@ namespace pot::tasks::details
             {
                 std::rethrow_exception(std::get<std::exception_ptr>(m_data));
             }
-            if constexpr (!std::is_void_v<T>)
+            if constexpr (std::is_copy_constructible_v<T>)
             {
                 return std::get<T>(m_data);
             }
+            else if constexpr (!std::is_void_v<T>)
+            {
+                // A move-only result is handed out once; a second get() would see a moved-from value.
+                if (std::exchange(m_consumed, true))
+                {
+                    throw std::logic_error("shared_state result already taken.");
+                }
+                return std::move(std::get<T>(m_data));
+            }
         }
 
         void wait() const
         {
-            while (!m_ready.load(std::memory_order_acquire))
+            if (spin_until_ready())
+            {
+                return;
+            }
+
+            for (uint32_t flags = announce_waiter(); !(flags & ready_flag); flags = announce_waiter())
+            {
+                pot::details::atomic_wait(m_flags, flags);
+            }
+        }
+
+        template <typename Clock, typename Duration>
+        bool wait_until(const std::chrono::time_point<Clock, Duration> &deadline) const
+        {
+            if (spin_until_ready())
+            {
+                return true;
+            }
+
+            const auto steady_deadline = std::chrono::steady_clock::now() +
+                                         std::chrono::ceil<std::chrono::steady_clock::duration>(deadline - Clock::now());
+            for (uint32_t flags = announce_waiter(); !(flags & ready_flag); flags = announce_waiter())
             {
-                std::this_thread::yield();
+                if (!pot::details::atomic_wait_until(m_flags, flags, steady_deadline))
+                {
+                    return is_ready();
+                }
             }
+            return true;
         }
 
-        bool is_ready() const 
+        template <typename Rep, typename Period>
+        bool wait_for(const std::chrono::duration<Rep, Period> &timeout) const
         {
-            return m_ready.load();
+            return wait_until(std::chrono::steady_clock::now() + timeout);
+        }
+
+        bool is_ready() const
+        {
+            POT_SCHEDULE_POINT();
+            return m_flags.load(std::memory_order_acquire) & ready_flag;
         }
 
     private:
-        std::atomic<bool> m_ready{false};
+        static constexpr uint32_t ready_flag = 1;
+        static constexpr uint32_t waiters_flag = 2;
+
+        static void *completed_marker() noexcept
+        {
+            static char marker;
+            return &marker;
+        }
+
+        bool spin_until_ready() const
+        {
+            pot::details::spin_wait spinner;
+            for (size_t i = 0; i < wait_spin_budget; ++i)
+            {
+                if (is_ready())
+                {
+                    return true;
+                }
+                spinner.spin_once();
+            }
+            return is_ready();
+        }
+
+        // Sets waiters_flag unless the state is already ready; returns the flags a sleeper should wait on.
+        uint32_t announce_waiter() const
+        {
+            POT_SCHEDULE_POINT();
+            uint32_t flags = m_flags.load(std::memory_order_acquire);
+            while (!(flags & (ready_flag | waiters_flag)))
+            {
+                POT_SCHEDULE_POINT();
+                if (m_flags.compare_exchange_weak(flags, flags | waiters_flag, std::memory_order_acquire))
+                {
+                    break;
+                }
+            }
+            return (flags & ready_flag) ? flags : (flags | waiters_flag);
+        }
+
+        mutable std::atomic<uint32_t> m_flags{0};
+        // nullptr, the awaiting coroutine's address, or completed_marker() once the result is published.
+        std::atomic<void *> m_continuation{nullptr};
         variant_type m_data{std::monostate{}};
-        std::vector<std::coroutine_handle<>> m_continuations;
+        bool m_consumed{false};
     };
 
-} // namespace pot::tasks::details
\ No newline at end of file
+} // namespace pot::tasks::details
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <chrono>
+#include <coroutine>
+#include <stdexcept>
+
+#include "cancellation.h"
+#include "executor.h"
+
+namespace pot
+{
+    // Suspends the coroutine on the executor's timer wheel; on expiry it is queued on the executor again.
+    // No worker is held while it sleeps. If the executor shuts down first, the sleep is cut short and throws
+    // operation_cancelled.
+    struct sleep_awaitable
+    {
+        executor &m_executor;
+        std::chrono::steady_clock::time_point m_deadline;
+        bool m_cancelled = false;
+
+        bool await_ready() const noexcept { return m_deadline <= std::chrono::steady_clock::now(); }
+
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            m_executor.timers().schedule_at(m_deadline, [this, handle](bool cancelled)
+                                            {
+                m_cancelled = cancelled;
+                m_executor.run_detached([handle]
+                                        { handle.resume(); }); });
+        }
+
+        void await_resume() const
+        {
+            if (m_cancelled)
+            {
+                throw operation_cancelled();
+            }
+        }
+    };
+
+    template <typename Clock, typename Duration>
+    [[nodiscard]] sleep_awaitable sleep_until(executor &executor, const std::chrono::time_point<Clock, Duration> &time_point)
+    {
+        if constexpr (std::is_same_v<Clock, std::chrono::steady_clock>)
+        {
+            return {executor, std::chrono::time_point_cast<std::chrono::steady_clock::duration>(time_point)};
+        }
+        else
+        {
+            return {executor, std::chrono::steady_clock::now() +
+                                  std::chrono::ceil<std::chrono::steady_clock::duration>(time_point - Clock::now())};
+        }
+    }
+
+    template <typename Rep, typename Period>
+    [[nodiscard]] sleep_awaitable sleep_for(executor &executor, const std::chrono::duration<Rep, Period> &duration)
+    {
+        return {executor, std::chrono::steady_clock::now() + std::chrono::ceil<std::chrono::steady_clock::duration>(duration)};
+    }
+
+    // co_await pot::sleep_for(d) from a coroutine running on an executor's worker resumes on the same executor.
+    template <typename Clock, typename Duration>
+    [[nodiscard]] sleep_awaitable sleep_until(const std::chrono::time_point<Clock, Duration> &time_point)
+    {
+        auto *executor = executor::current();
+        if (!executor)
+        {
+            throw std::logic_error("pot::sleep_until outside an executor's worker needs the executor to resume on.");
+        }
+        return sleep_until(*executor, time_point);
+    }
+
+    template <typename Rep, typename Period>
+    [[nodiscard]] sleep_awaitable sleep_for(const std::chrono::duration<Rep, Period> &duration)
+    {
+        auto *executor = executor::current();
+        if (!executor)
+        {
+            throw std::logic_error("pot::sleep_for outside an executor's worker needs the executor to resume on.");
+        }
+        return sleep_for(*executor, duration);
+    }
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace pot::details
+{
+    // Thread-local free lists of small blocks, bucketed by 16-byte size classes.
+    // A block freed on another thread joins that thread's list; lists are capped so a
+    // producer/consumer imbalance hands memory back to the global heap instead of hoarding it.
+    class small_object_pool
+    {
+    public:
+        static constexpr std::size_t granularity = 16;
+        static constexpr std::size_t max_block_size = 512;
+        static constexpr std::size_t max_cached_blocks = 1024;
+
+        static void *allocate(std::size_t size)
+        {
+            if (size > max_block_size || tl_cache_destroyed)
+            {
+                return ::operator new(size);
+            }
+
+            free_list &list = cache().m_lists[size_class(size)];
+            if (free_block *block = list.m_head)
+            {
+                list.m_head = block->m_next;
+                --list.m_count;
+                return block;
+            }
+            return ::operator new(block_size(size));
+        }
+
+        static void deallocate(void *ptr, std::size_t size) noexcept
+        {
+            if (!ptr)
+            {
+                return;
+            }
+
+            if (size > max_block_size || tl_cache_destroyed)
+            {
+                ::operator delete(ptr);
+                return;
+            }
+
+            free_list &list = cache().m_lists[size_class(size)];
+            if (list.m_count >= max_cached_blocks)
+            {
+                ::operator delete(ptr);
+                return;
+            }
+            list.m_head = ::new (ptr) free_block{list.m_head};
+            ++list.m_count;
+        }
+
+    private:
+        struct free_block
+        {
+            free_block *m_next;
+        };
+
+        struct free_list
+        {
+            free_block *m_head{nullptr};
+            std::size_t m_count{0};
+        };
+
+        struct thread_cache
+        {
+            std::array<free_list, max_block_size / granularity> m_lists{};
+
+            ~thread_cache()
+            {
+                tl_cache_destroyed = true;
+                for (auto &list : m_lists)
+                {
+                    while (free_block *block = list.m_head)
+                    {
+                        list.m_head = block->m_next;
+                        ::operator delete(block);
+                    }
+                }
+            }
+        };
+
+        static constexpr std::size_t size_class(std::size_t size) noexcept
+        {
+            return size == 0 ? 0 : (size - 1) / granularity;
+        }
+
+        static constexpr std::size_t block_size(std::size_t size) noexcept
+        {
+            return (size_class(size) + 1) * granularity;
+        }
+
+        static thread_cache &cache() noexcept
+        {
+            static thread_local thread_cache instance;
+            return instance;
+        }
+
+        // Trivially destructible, so it is still readable while other thread_locals are torn down.
+        static inline thread_local bool tl_cache_destroyed = false;
+    };
+
+    template <typename T>
+    class pool_allocator
+    {
+    public:
+        using value_type = T;
+
+        pool_allocator() noexcept = default;
+
+        template <typename U>
+        pool_allocator(const pool_allocator<U> &) noexcept {}
+
+        T *allocate(std::size_t n)
+        {
+            if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+            {
+                return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+            }
+            else
+            {
+                return static_cast<T *>(small_object_pool::allocate(n * sizeof(T)));
+            }
+        }
+
+        void deallocate(T *ptr, std::size_t n) noexcept
+        {
+            if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+            {
+                ::operator delete(ptr, std::align_val_t(alignof(T)));
+            }
+            else
+            {
+                small_object_pool::deallocate(ptr, n * sizeof(T));
+            }
+        }
+
+        template <typename U>
+        bool operator==(const pool_allocator<U> &) const noexcept { return true; }
+    };
+
+    template <typename T, typename... Args>
+    T *pool_new(Args &&...args)
+    {
+        pool_allocator<T> allocator;
+        T *ptr = allocator.allocate(1);
+        try
+        {
+            return ::new (static_cast<void *>(ptr)) T(std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            allocator.deallocate(ptr, 1);
+            throw;
+        }
+    }
+
+    template <typename T>
+    void pool_delete(T *ptr) noexcept
+    {
+        if (ptr)
+        {
+            ptr->~T();
+            pool_allocator<T>().deallocate(ptr, 1);
+        }
+    }
+}
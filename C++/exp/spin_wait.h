@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <thread>
+
+namespace pot::details
+{
+    inline void cpu_relax() noexcept
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+        asm volatile("yield");
+#endif
+    }
+
+    // Exponential backoff: bursts of pause instructions that double in length, then yielding the time slice.
+    class spin_wait
+    {
+    public:
+        void spin_once() noexcept
+        {
+            if (m_count < yield_threshold)
+            {
+                for (uint32_t i = 0; i < (1u << m_count); ++i)
+                {
+                    cpu_relax();
+                }
+                ++m_count;
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        void reset() noexcept { m_count = 0; }
+
+    private:
+        static constexpr uint32_t yield_threshold = 6;
+        uint32_t m_count{0};
+    };
+}
@@ -13,17 +13,17 @@
 #include <variant>
 #include <atomic>
 
+#include "shared_state.h"
+#include "frame_allocator.h"
+
 namespace pot::coroutines
 {
+    // The coroutine's result lives in the promise, i.e. in the coroutine frame itself, so a task is a single
+    // allocation; pooled_frame recycles it through the thread's free lists.
     template <typename T>
-    class basic_promise_type
+    class basic_promise_type : public tasks::details::shared_state<T>, public details::pooled_frame
     {
     public:
-        using value_type = T;
-        using variant_type = std::conditional_t<std::is_void_v<T>,
-                                                std::variant<std::monostate, std::exception_ptr>,
-                                                std::variant<std::monostate, T, std::exception_ptr>>;
-
         basic_promise_type() {}
 
         // auto operator co_await() noexcept
@@ -56,98 +56,28 @@ namespace pot::coroutines
         //     }
         // };
 
-        template <typename U = T>
-            requires(!std::is_void_v<T> && std::is_convertible_v<U, T>)
-        void set_value(U &&value)
-        {
-            m_data.template emplace<T>(std::forward<U>(value));
-            if (m_ready.exchange(true, std::memory_order_release))
-            {
-                throw std::runtime_error("Value already set in promise_type.");
-            }
-            for (auto &cont : m_continuations)
-            {
-                cont.resume();
-            }
-            m_continuations.clear();
-        }
-
-        void set_value()
-            requires std::is_void_v<T>
-        {
-            m_data = std::monostate{};
-            if (m_ready.exchange(true, std::memory_order_release))
-            {
-                throw std::runtime_error("Value already set in promise_type.");
-            }
-            for (auto &cont : m_continuations)
-            {
-                cont.resume();
-            }
-            m_continuations.clear();
-        }
-
-        void set_exception(std::exception_ptr ex)
-        {
-            m_data = ex;
-            if (m_ready.exchange(true, std::memory_order_release))
-            {
-                throw std::runtime_error("Exception already set in promise_type.");
-            }
-            for (auto &cont : m_continuations)
-            {
-                cont.resume();
-            }
-            m_continuations.clear();
-        }
-
-        bool is_ready() const noexcept
+        // Publishes the result and transfers straight into the awaiting coroutine (or back to the resumer
+        // if nobody awaits yet), so long co_await chains run at constant stack depth.
+        struct final_awaiter
         {
-            return m_ready.load(std::memory_order_acquire);
-        }
+            bool await_ready() const noexcept { return false; }
 
-        void set_continuation(std::coroutine_handle<> continuation)
-        {
-            if (m_ready.load(std::memory_order_acquire))
-            {
-                continuation.resume();
-            }
-            else
+            template <typename Promise>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
             {
-                m_continuations.push_back(continuation);
+                return handle.promise().complete();
             }
-        }
 
-        T get()
-        {
-            wait();
-            if (std::holds_alternative<std::exception_ptr>(m_data))
-            {
-                std::rethrow_exception(std::get<std::exception_ptr>(m_data));
-            }
-            if constexpr (!std::is_void_v<T>)
-            {
-                return std::get<T>(m_data);
-            }
-        }
-
-        void wait() const
-        {
-            while (!m_ready.load(std::memory_order_acquire))
-            {
-                std::this_thread::yield();
-            }
-        }
-
-        static constexpr std::suspend_never initial_suspend() noexcept { return {}; }
-        static constexpr std::suspend_always final_suspend() noexcept { return {}; }
+            void await_resume() const noexcept {}
+        };
 
-    private:
-        std::atomic<bool> m_ready{false};
-        variant_type m_data{std::monostate{}};
-        std::vector<std::coroutine_handle<>> m_continuations;
+        // Tasks are lazy: they start when awaited, started, or waited on.
+        static constexpr std::suspend_always initial_suspend() noexcept { return {}; }
+        static constexpr final_awaiter final_suspend() noexcept { return {}; }
     };
 
+    // GCC 12 destroys temporaries of a co_await expression twice (bug 99576), so code in this library names an
+    // awaitable, or a lambda capturing by value, before awaiting it: `auto all = when_all(...); co_await all;`.
     template <typename T>
     class [[nodiscard]] task
     {
@@ -165,27 +95,16 @@ namespace pot::coroutines
                 return get_return_object();
             }
 
-            std::suspend_always yield_value(T value)
-            {
-                this->m_state->set_value(std::move(value));
-                return {};
-            }
-
-            auto get_shared_state() const noexcept
-            {
-                return this->m_state;
-            }
-
             template <typename U>
                 requires std::convertible_to<U, T>
             void return_value(U &&value)
             {
-                this->set_value(std::forward<U>(value));
+                this->store_value(std::forward<U>(value));
             }
 
             void unhandled_exception()
             {
-                this->set_exception(std::current_exception());
+                this->store_exception(std::current_exception());
             }
         };
 
@@ -193,7 +112,7 @@ namespace pot::coroutines
 
         explicit task(handle_type h) noexcept : m_handle(h) {}
         task() noexcept : m_handle(nullptr) {}
-        task(task &&rhs) noexcept : m_handle(rhs.m_handle)
+        task(task &&rhs) noexcept : m_handle(rhs.m_handle), m_started(rhs.m_started)
         {
             rhs.m_handle = nullptr;
         }
@@ -202,11 +121,12 @@ namespace pot::coroutines
         {
             if (this != &rhs)
             {
-                if (m_handle)
+                if (m_handle && (!m_started || m_handle.done()))
                 {
                     m_handle.destroy();
                 }
                 m_handle = rhs.m_handle;
+                m_started = rhs.m_started;
                 rhs.m_handle = nullptr;
             }
             return *this;
@@ -217,44 +137,37 @@ namespace pot::coroutines
 
         ~task()
         {
-            if (m_handle && m_handle.done())
+            if (m_handle && (!m_started || m_handle.done()))
             {
                 m_handle.destroy();
             }
         }
 
+        // Runs the task on the calling thread up to its first suspension point without waiting for it.
+        void start()
+        {
+            if (m_handle && !std::exchange(m_started, true))
+            {
+                m_handle.resume();
+            }
+        }
+
+        [[nodiscard]] bool started() const noexcept { return m_started; }
+
         bool await_ready() const noexcept
         {
-            return m_handle && m_handle.promise().is_ready();
+            return !m_handle || (m_started && m_handle.promise().is_ready());
         }
 
-        void await_suspend(std::coroutine_handle<> continuation) noexcept
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation)
         {
-            // if (!m_handle)
-            // {
-            //     continuation.resume();
-            //     return;
-            // }
-            // m_handle.promise().get_shared_state()->set_continuation(continuation);
-
-            // try
-            // {
-            //     if (m_handle && !m_handle.done())
-            //     {
-            //         m_handle.resume();
-            //     }
-            //     else
-            //     {
-            //         continuation.resume();
-            //     }
-            // }
-            // catch (...)
-            // {
-            //     m_handle.promise().set_exception(std::current_exception());
-            //     continuation.resume();
-            // }
-
-            m_handle.promise().set_continuation(continuation);
+            // An unstarted task is entered by symmetric transfer; a running one resumes us from its final_suspend.
+            const bool first_start = !std::exchange(m_started, true);
+            if (m_handle.promise().set_continuation(continuation))
+            {
+                return first_start ? std::coroutine_handle<>(m_handle) : std::noop_coroutine();
+            }
+            return continuation;
         }
 
         T await_resume()
@@ -276,30 +189,43 @@ namespace pot::coroutines
 
         T get()
         {
+            start();
             return await_resume();
         }
 
-        class iterator
+        // Awaits completion without fetching (or rethrowing) the result; used by the combinators.
+        auto when_ready() noexcept
         {
-            handle_type m_handle;
+            struct ready_awaiter
+            {
+                task &m_task;
 
-        public:
-            using value_type = T;
-            using difference_type = std::ptrdiff_t;
+                bool await_ready() const noexcept { return m_task.await_ready(); }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) { return m_task.await_suspend(continuation); }
+                void await_resume() const noexcept {}
+            };
+            return ready_awaiter{*this};
+        }
 
-            iterator(handle_type h = nullptr) : m_handle(h) {}
+        void wait()
+        {
+            start();
+            m_handle.promise().wait();
+        }
 
-            value_type operator*() const { return m_handle.promise().current_value(); }
-            iterator &operator++()
-            {
-                m_handle.resume();
-                return *this;
-            }
-            bool operator==(const iterator &) const = default;
-        };
+        template <typename Rep, typename Period>
+        bool wait_for(const std::chrono::duration<Rep, Period> &timeout)
+        {
+            start();
+            return m_handle.promise().wait_for(timeout);
+        }
 
-        auto begin() { return iterator(m_handle); }
-        auto end() { return iterator(); }
+        template <typename Clock, typename Duration>
+        bool wait_until(const std::chrono::time_point<Clock, Duration> &deadline)
+        {
+            start();
+            return m_handle.promise().wait_until(deadline);
+        }
 
         // auto operator co_await() noexcept
         // {
@@ -327,6 +253,7 @@ namespace pot::coroutines
 
     private:
         handle_type m_handle;
+        bool m_started{false};
     };
 
     template <>
@@ -344,12 +271,12 @@ namespace pot::coroutines
 
         void return_void()
         {
-            this->set_value();
+            this->store_value();
         }
 
         void unhandled_exception()
         {
-            this->set_exception(std::current_exception());
+            this->store_exception(std::current_exception());
         }
     };
 }
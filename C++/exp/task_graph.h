@@ -0,0 +1,365 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "executor.h"
+#include "frame_allocator.h"
+#include "shared_state.h"
+#include "task_coroutine.h"
+#include "unique_function.h"
+
+namespace pot::details
+{
+    // Fire-and-forget coroutine that frees itself when it finishes; runs a coroutine node of a task_graph.
+    struct graph_node_runner
+    {
+        struct promise_type : pooled_frame
+        {
+            graph_node_runner get_return_object() noexcept { return {}; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() noexcept {}
+            void unhandled_exception() noexcept { std::terminate(); }
+        };
+    };
+}
+
+namespace pot
+{
+    // A DAG of jobs. Nodes are callables returning void or a coroutines::task<void>; an edge a -> b makes b wait
+    // for a. run() hands the nodes without predecessors to the executor and from then on every finished node
+    // counts down its successors' in-degree counters; a successor that reaches zero runs right away on the same
+    // thread (the first one) or is submitted (the others). Nothing blocks a worker, and a task node's worker is
+    // free while its task is suspended.
+    //
+    // A built graph can be run again once the previous run completed. Only changes to the structure reallocate;
+    // re-running just resets the counters.
+    //
+    //     pot::task_graph graph;
+    //     auto load = graph.emplace([&] { ... });
+    //     auto left = graph.emplace([&] { ... });
+    //     auto right = graph.emplace([&]() -> pot::coroutines::task<void> { ... });
+    //     auto merge = graph.emplace([&] { ... });
+    //     load.precede(left, right);
+    //     merge.succeed(left, right);
+    //     graph.run(pool).get();
+    class task_graph
+    {
+    public:
+        class node
+        {
+        public:
+            // This node runs before each of `others`.
+            template <typename... Nodes>
+            node &precede(const Nodes &...others)
+            {
+                (m_graph->add_edge(m_index, others.m_index), ...);
+                return *this;
+            }
+
+            // This node runs after each of `others`.
+            template <typename... Nodes>
+            node &succeed(const Nodes &...others)
+            {
+                (m_graph->add_edge(others.m_index, m_index), ...);
+                return *this;
+            }
+
+            [[nodiscard]] size_t index() const noexcept { return m_index; }
+
+        private:
+            friend class task_graph;
+
+            node(task_graph *graph, size_t index) noexcept : m_graph(graph), m_index(index) {}
+
+            task_graph *m_graph;
+            size_t m_index;
+        };
+
+        task_graph() = default;
+        task_graph(const task_graph &) = delete;
+        task_graph &operator=(const task_graph &) = delete;
+
+        template <typename Func>
+            requires std::is_invocable_v<Func &>
+        node emplace(Func func)
+        {
+            throw_if_running();
+            auto &added = m_nodes.emplace_back();
+            if constexpr (traits::concepts::is_task<std::invoke_result_t<Func &>>)
+            {
+                added.m_task_work = std::move(func);
+            }
+            else
+            {
+                added.m_work = [func = std::move(func)]() mutable
+                { std::invoke(func); };
+            }
+            m_built = false;
+            return node(this, m_nodes.size() - 1);
+        }
+
+        [[nodiscard]] size_t size() const noexcept { return m_nodes.size(); }
+
+        // Starts a run and returns the task that completes with it. If a node throws, the nodes that have not
+        // started are skipped and the task rethrows the first exception.
+        coroutines::task<void> run(executor &executor)
+        {
+            throw_if_running();
+            build();
+            m_running.store(true, std::memory_order_relaxed);
+
+            m_executor = &executor;
+            m_failed.store(false, std::memory_order_relaxed);
+            m_exception = nullptr;
+            m_done.emplace();
+            for (size_t i = 0; i < m_nodes.size(); ++i)
+            {
+                m_pending[i].store(m_in_degree[i], std::memory_order_relaxed);
+            }
+            m_remaining.store(m_nodes.size(), std::memory_order_relaxed);
+
+            if (m_nodes.empty())
+            {
+                finish_run();
+            }
+            // Roots are listed first in m_order.
+            for (size_t i = 0; i < m_root_count; ++i)
+            {
+                executor.run_detached([this, root = m_order[i]]
+                                      { run_node(root); });
+            }
+            return join(this);
+        }
+
+    private:
+        static constexpr size_t none = std::numeric_limits<size_t>::max();
+
+        struct node_data
+        {
+            details::unique_function<void()> m_work;
+            details::unique_function<coroutines::task<void>()> m_task_work;
+            std::vector<size_t> m_successors;
+        };
+
+        void throw_if_running() const
+        {
+            if (m_running.load(std::memory_order_acquire))
+            {
+                throw std::logic_error("task_graph is running.");
+            }
+        }
+
+        void add_edge(size_t from, size_t to)
+        {
+            throw_if_running();
+            m_nodes[from].m_successors.push_back(to);
+            m_built = false;
+        }
+
+        // Flattens the successor lists, counts in-degrees and checks that the graph is acyclic.
+        void build()
+        {
+            if (m_built)
+            {
+                return;
+            }
+
+            const size_t count = m_nodes.size();
+            m_in_degree.assign(count, 0);
+            m_successor_begin.assign(count + 1, 0);
+            m_successors.clear();
+            for (size_t i = 0; i < count; ++i)
+            {
+                m_successor_begin[i] = m_successors.size();
+                for (size_t successor : m_nodes[i].m_successors)
+                {
+                    m_successors.push_back(successor);
+                    ++m_in_degree[successor];
+                }
+            }
+            m_successor_begin[count] = m_successors.size();
+
+            // Kahn's algorithm: roots first, then every node after all of its predecessors.
+            m_order.clear();
+            std::vector<size_t> in_degree = m_in_degree;
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (in_degree[i] == 0)
+                {
+                    m_order.push_back(i);
+                }
+            }
+            m_root_count = m_order.size();
+            for (size_t next = 0; next < m_order.size(); ++next)
+            {
+                const size_t current = m_order[next];
+                for (size_t s = m_successor_begin[current]; s < m_successor_begin[current + 1]; ++s)
+                {
+                    if (--in_degree[m_successors[s]] == 0)
+                    {
+                        m_order.push_back(m_successors[s]);
+                    }
+                }
+            }
+            if (m_order.size() != count)
+            {
+                throw std::logic_error("task_graph has a cycle.");
+            }
+
+            m_pending = std::vector<std::atomic<size_t>>(count);
+            m_built = true;
+        }
+
+        void run_node(size_t index)
+        {
+            while (index != none)
+            {
+                auto &current = m_nodes[index];
+                if (current.m_task_work)
+                {
+                    run_task_nodes(index);
+                    return;
+                }
+                if (current.m_work && !m_failed.load(std::memory_order_relaxed))
+                {
+                    try
+                    {
+                        current.m_work();
+                    }
+                    catch (...)
+                    {
+                        fail(std::current_exception());
+                    }
+                }
+                index = finish_node(index);
+            }
+        }
+
+        // Runs `index` and then, like run_node, the successor it releases, until none is left. A task node may
+        // resume on any thread; the loop carries on from there. Successors stay in this one frame, and each task is
+        // started before it is awaited, so one that completes synchronously returns here instead of resuming us
+        // from its final_suspend: a chain of such nodes runs at constant stack depth even where symmetric transfer
+        // is not a tail call (sanitizer builds).
+        details::graph_node_runner run_task_nodes(size_t index)
+        {
+            while (index != none)
+            {
+                auto &current = m_nodes[index];
+                if (!m_failed.load(std::memory_order_relaxed))
+                {
+                    try
+                    {
+                        if (current.m_task_work)
+                        {
+                            auto work = current.m_task_work();
+                            work.start();
+                            co_await work;
+                        }
+                        else if (current.m_work)
+                        {
+                            current.m_work();
+                        }
+                    }
+                    catch (...)
+                    {
+                        fail(std::current_exception());
+                    }
+                }
+                index = finish_node(index);
+            }
+        }
+
+        // Releases the successors and returns one that became ready, to be run by the caller, or none.
+        // The graph must not be touched after the last node finished: the awaiter may already be gone.
+        size_t finish_node(size_t index)
+        {
+            size_t next = none;
+            for (size_t s = m_successor_begin[index]; s < m_successor_begin[index + 1]; ++s)
+            {
+                const size_t successor = m_successors[s];
+                if (m_pending[successor].fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    if (next == none)
+                    {
+                        next = successor;
+                    }
+                    else
+                    {
+                        m_executor->run_detached([this, successor]
+                                                 { run_node(successor); });
+                    }
+                }
+            }
+
+            if (m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                finish_run();
+            }
+            return next;
+        }
+
+        void fail(std::exception_ptr exception)
+        {
+            if (!m_failed.exchange(true, std::memory_order_acq_rel))
+            {
+                m_exception = std::move(exception);
+            }
+        }
+
+        void finish_run()
+        {
+            if (m_failed.load(std::memory_order_acquire))
+            {
+                m_done->store_exception(m_exception);
+            }
+            else
+            {
+                m_done->store_value();
+            }
+            m_running.store(false, std::memory_order_release);
+            m_done->complete().resume();
+        }
+
+        static coroutines::task<void> join(task_graph *graph)
+        {
+            struct awaiter
+            {
+                tasks::details::shared_state<void> &m_done;
+
+                bool await_ready() const noexcept { return m_done.is_ready(); }
+                bool await_suspend(std::coroutine_handle<> continuation) { return m_done.set_continuation(continuation); }
+                void await_resume() { m_done.get(); }
+            };
+            co_await awaiter{*graph->m_done};
+        }
+
+        std::vector<node_data> m_nodes;
+        bool m_built = false;
+
+        // Built once per structure: successors in one array (node i owns [m_successor_begin[i],
+        // m_successor_begin[i + 1])), in-degrees, and a topological order starting with the roots.
+        std::vector<size_t> m_successors;
+        std::vector<size_t> m_successor_begin;
+        std::vector<size_t> m_in_degree;
+        std::vector<size_t> m_order;
+        size_t m_root_count = 0;
+
+        // Per run.
+        std::vector<std::atomic<size_t>> m_pending;
+        std::atomic<size_t> m_remaining{0};
+        std::atomic<bool> m_running{false};
+        std::atomic<bool> m_failed{false};
+        std::exception_ptr m_exception;
+        std::optional<tasks::details::shared_state<void>> m_done;
+        executor *m_executor = nullptr;
+    };
+}
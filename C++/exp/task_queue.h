@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <queue>
+#include <span>
+
+#include "unique_function.h"
+
+namespace pot::details
+{
+    // Mutex-protected FIFO of jobs whose emptiness can be polled without taking the lock,
+    // so idle workers can spin on it without fighting the producers.
+    class task_queue
+    {
+    public:
+        void push(unique_function<void()> task)
+        {
+            std::lock_guard lock(m_mutex);
+            m_tasks.push(std::move(task));
+            m_size.store(m_tasks.size(), std::memory_order_release);
+        }
+
+        // Moves every job in under a single lock acquisition.
+        void push_bulk(std::span<unique_function<void()>> tasks)
+        {
+            std::lock_guard lock(m_mutex);
+            for (auto &task : tasks)
+            {
+                m_tasks.push(std::move(task));
+            }
+            m_size.store(m_tasks.size(), std::memory_order_release);
+        }
+
+        unique_function<void()> try_pop()
+        {
+            if (empty())
+            {
+                return nullptr;
+            }
+
+            std::lock_guard lock(m_mutex);
+            if (m_tasks.empty())
+            {
+                return nullptr;
+            }
+            auto task = std::move(m_tasks.front());
+            m_tasks.pop();
+            m_size.store(m_tasks.size(), std::memory_order_relaxed);
+            return task;
+        }
+
+        [[nodiscard]] bool empty() const noexcept
+        {
+            return m_size.load(std::memory_order_acquire) == 0;
+        }
+
+        [[nodiscard]] size_t size() const noexcept
+        {
+            return m_size.load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::queue<unique_function<void()>> m_tasks;
+        std::atomic_size_t m_size{0};
+    };
+}
@@ -1,19 +1,30 @@
 #pragma once
 
 #include <thread>
-#include <queue>
-#include <condition_variable>
-#include <mutex>
 #include <functional>
 #include <future>
 
+#include "unique_function.h"
+#include "task_queue.h"
+#include "event_count.h"
+#include "spin_wait.h"
+#include "metrics.h"
+#include "topology.h"
+
 namespace pot
 {
+    class executor;
+
     class thread
     {
     public:
-        thread(size_t id, std::string thread_name)
-            : m_id(id), m_thread_name(std::move(thread_name)) {}
+        static constexpr size_t default_spin_budget = 32;
+
+        // Pooled threads share one idle_event with their siblings; a standalone thread parks on its own.
+        thread(size_t id, std::string thread_name, details::event_count *idle_event = nullptr,
+               size_t spin_budget = default_spin_budget)
+            : m_id(id), m_thread_name(std::move(thread_name)),
+              m_idle_event(idle_event ? idle_event : &m_own_idle_event), m_spin_budget(spin_budget) {}
         virtual ~thread() = default;
 
         virtual bool joinable() const = 0;
@@ -22,18 +33,31 @@ namespace pot
         virtual void notify() = 0;
 
         template <typename Func, typename... Args>
-        auto run(Func &&func, Args &&...args) -> std::invoke_result_t<Func, Args...>
+        auto run(Func &&func, Args &&...args) -> std::future<std::invoke_result_t<Func, Args...>>
             requires std::is_invocable_v<Func, Args...>
         {
-            using return_type = decltype(func(args...));
-            auto task = std::make_shared<std::packaged_task<return_type()>>(std::function<return_type()>(std::forward<Func>(func), std::forward<Args>(args)...));
-            std::future<return_type> result = task->get_future();
-            {
-                std::lock_guard lock(m_mutex);
-                m_tasks.emplace([task]
-                                { (*task)(); });
-            }
-            m_condition.notify_one();
+            using return_type = std::invoke_result_t<Func, Args...>;
+
+            std::promise<return_type> promise(std::allocator_arg, details::pool_allocator<std::byte>{});
+            std::future<return_type> result = promise.get_future();
+            run_detached([promise = std::move(promise), func = std::forward<Func>(func), ... args = std::forward<Args>(args)]() mutable
+                         {
+                try
+                {
+                    if constexpr (std::is_void_v<return_type>)
+                    {
+                        std::invoke(func, args...);
+                        promise.set_value();
+                    }
+                    else
+                    {
+                        promise.set_value(std::invoke(func, args...));
+                    }
+                }
+                catch (...)
+                {
+                    promise.set_exception(std::current_exception());
+                } });
             return result;
         }
 
@@ -41,25 +65,107 @@ namespace pot
         void run_detached(Func &&func, Args &&...args)
             requires std::is_invocable_v<Func, Args...>
         {
+            if constexpr (sizeof...(Args) == 0)
+            {
+                m_tasks.push(std::forward<Func>(func));
+            }
+            else
             {
-                std::lock_guard lock(m_mutex);
-                m_tasks.emplace(std::function<void()>(std::forward<Func>(func), std::forward<Args>(args)...));
+                m_tasks.push([func = std::forward<Func>(func), ... args = std::forward<Args>(args)]() mutable
+                             { std::invoke(func, args...); });
             }
-            m_condition.notify_one();
+            m_metrics.on_submitted(m_tasks.size());
+            notify();
         }
 
         [[nodiscard]] size_t id() const { return m_id; }
         [[nodiscard]] std::string_view thread_name() const { return m_thread_name; }
+        [[nodiscard]] const details::worker_metrics &metrics() const { return m_metrics; }
+
+        // Restricts the worker to one CPU; its node is remembered so that siblings can prefer nearby victims.
+        bool pin(int cpu)
+        {
+            m_cpu = cpu;
+            m_node = details::cpu_topology::instance().node_of(cpu);
+            return details::pin_thread(m_thread.native_handle(), cpu);
+        }
+
+        // -1 while the worker is not pinned.
+        [[nodiscard]] int cpu() const { return m_cpu; }
+        [[nodiscard]] int node() const { return m_node; }
+
+        // The worker running on the calling thread, or nullptr.
+        [[nodiscard]] static thread *current() noexcept { return tl_current_thread; }
+
+        // Set by the pool right after constructing the worker, before it accepts any work.
+        void set_owner(executor *owner) noexcept { m_owner = owner; }
+        [[nodiscard]] executor *owner() const noexcept { return m_owner; }
 
     protected:
-        std::mutex m_mutex;
-        std::condition_variable m_condition;
-        std::queue<std::function<void()>> m_tasks;
+        // Spins for up to m_spin_budget backoff rounds, then parks on the idle event until a producer signals it.
+        template <typename Predicate>
+        void idle_wait(const std::stop_token &stop_token, Predicate &&has_work)
+        {
+            details::spin_wait spinner;
+            for (size_t i = 0; i < m_spin_budget; ++i)
+            {
+                if (has_work() || stop_token.stop_requested())
+                {
+                    return;
+                }
+                spinner.spin_once();
+            }
+
+            const auto key = m_idle_event->prepare_wait();
+            if (has_work() || stop_token.stop_requested())
+            {
+                m_idle_event->cancel_wait();
+                return;
+            }
+            if constexpr (details::worker_metrics::enabled)
+            {
+                const auto parked_at = details::metrics_clock::now();
+                m_idle_event->wait(key);
+                m_metrics.on_parked(details::metrics_clock::now() - parked_at);
+            }
+            else
+            {
+                m_idle_event->wait(key);
+            }
+        }
+
+        // Called first thing on the worker's own thread.
+        void make_current() noexcept
+        {
+            tl_current_thread = this;
+            m_metrics.make_current();
+        }
+
+        void execute(details::unique_function<void()> &task)
+        {
+            task();
+            m_metrics.on_executed();
+        }
+
+        details::task_queue m_tasks;
+        details::event_count m_own_idle_event;
 
         size_t m_id;
         std::string m_thread_name;
 
+        details::event_count *m_idle_event;
+        size_t m_spin_budget;
+
+        int m_cpu = -1;
+        int m_node = -1;
+        executor *m_owner = nullptr;
+
+        [[no_unique_address]] details::worker_metrics m_metrics;
+
         std::jthread m_thread;
         std::stop_source m_stop_source;
+
+    private:
+        static inline thread_local thread *tl_current_thread = nullptr;
     };
 }
\ No newline at end of file
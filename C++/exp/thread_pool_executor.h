@@ -11,6 +11,28 @@
 
 namespace pot::executors
 {
+    enum class pinning_policy
+    {
+        // Leave placement to the OS scheduler.
+        none,
+        // Fill one NUMA node (core by core) before using the next.
+        compact,
+        // Alternate between nodes, and between cores within a node.
+        scatter,
+        // Worker i runs on thread_pool_options::cpus[i % cpus.size()].
+        cpu_list,
+    };
+
+    struct thread_pool_options
+    {
+        // Backoff rounds an idle worker spins before parking. Higher values burn more CPU
+        // but pick up new work faster; 0 parks as soon as the queues are empty.
+        size_t spin_budget = pot::thread::default_spin_budget;
+
+        pinning_policy pinning = pinning_policy::none;
+        std::vector<int> cpus{};
+    };
+
     template <bool global_queue_mode>
     class thread_pool_executor final : public executor
     {
@@ -24,7 +46,8 @@ namespace pot::executors
 
         using thread_type = mode_type<pot::global_thread, pot::local_thread>;
 
-        explicit thread_pool_executor(std::string name, size_t num_threads = std::thread::hardware_concurrency())
+        explicit thread_pool_executor(std::string name, size_t num_threads = std::thread::hardware_concurrency(),
+                                      thread_pool_options options = {})
             : executor(std::move(name)), m_shutdown(false)
         {
             m_threads.reserve(num_threads);
@@ -33,7 +56,7 @@ namespace pot::executors
                 for (size_t i = 0; i < num_threads; ++i)
                 {
                     m_threads.push_back(std::make_unique<thread_type>(
-                        m_tasks_mutex, m_condition, m_tasks, i, "Thread " + std::to_string(i)));
+                        m_tasks, m_idle_event, i, "Thread " + std::to_string(i), options.spin_budget));
                 }
             }
             else
@@ -41,11 +64,31 @@ namespace pot::executors
                 m_current_thread = 0;
                 for (size_t i = 0; i < num_threads; ++i)
                 {
-                    m_threads.push_back(std::make_unique<thread_type>(i, "Thread " + std::to_string(i)));
+                    m_threads.push_back(std::make_unique<thread_type>(
+                        i, "Thread " + std::to_string(i), &m_idle_event, options.spin_budget));
+                }
+            }
+
+            for (auto &thread : m_threads)
+            {
+                thread->set_owner(this);
+            }
+
+            const auto placement = worker_cpus(options, num_threads);
+            for (size_t i = 0; i < placement.size(); ++i)
+            {
+                m_threads[i]->pin(placement[i]);
+            }
+
+            if constexpr (!global_queue_mode)
+            {
+                for (size_t i = 0; i < num_threads; ++i)
+                {
+                    m_threads[i]->set_steal_order(steal_order(i));
                 }
                 for (auto &thread : m_threads)
                 {
-                    dynamic_cast<local_thread *>(thread.get())->set_other_workers(&m_threads);
+                    thread->set_other_workers(&m_threads);
                 }
             }
         }
@@ -54,6 +97,7 @@ namespace pot::executors
 
         void shutdown() override
         {
+            stop_timers();
             m_shutdown = true;
 
             for (auto &thread : m_threads)
@@ -61,17 +105,7 @@ namespace pot::executors
                 thread->request_stop();
             }
 
-            if constexpr (global_queue_mode)
-            {
-                m_condition.notify_all();
-            }
-            else
-            {
-                for (auto &thread : m_threads)
-                {
-                    thread->notify();
-                }
-            }
+            m_idle_event.notify_all();
 
             for (auto &thread : m_threads)
             {
@@ -84,30 +118,150 @@ namespace pot::executors
 
         [[nodiscard]] size_t thread_count() const override { return m_threads.size(); }
 
+        [[nodiscard]] pot::metrics::executor_snapshot metrics() const override
+        {
+            pot::metrics::executor_snapshot snapshot{.name = m_name, .taken_at = std::chrono::steady_clock::now()};
+            snapshot.workers.reserve(m_threads.size());
+            for (const auto &thread : m_threads)
+            {
+                auto &worker = snapshot.workers.emplace_back();
+                worker.id = thread->id();
+                worker.name = thread->thread_name();
+                thread->metrics().fill(worker);
+            }
+            if constexpr (global_queue_mode)
+            {
+                snapshot.shared_queue.name = "Shared queue";
+                m_queue_metrics.fill(snapshot.shared_queue);
+            }
+            return snapshot;
+        }
+
     protected:
-        void derived_execute(std::function<void()> func) override
+        void derived_execute(details::unique_function<void()> func) override
         {
+            stamp_latency(func);
+
             if constexpr (global_queue_mode)
             {
+                m_tasks.push(std::move(func));
+                m_queue_metrics.on_submitted(m_tasks.size());
+                m_idle_event.notify_one();
+            }
+            else
+            {
+                if (auto *worker = local_thread::current(); worker && worker->is_worker_of(&m_threads))
                 {
-                    std::lock_guard lock(m_tasks_mutex);
-                    m_tasks.emplace(std::move(func));
+                    worker->submit(std::move(func));
                 }
-                m_condition.notify_one();
+                else
+                {
+                    m_threads[m_current_thread++ % m_threads.size()]->submit(std::move(func));
+                }
+            }
+        }
+
+        void derived_execute_bulk(std::span<details::unique_function<void()>> funcs,
+                                  std::optional<size_t> first_worker) override
+        {
+            for (auto &func : funcs)
+            {
+                stamp_latency(func);
+            }
+
+            if constexpr (global_queue_mode)
+            {
+                m_tasks.push_bulk(funcs);
+                m_queue_metrics.on_submitted(m_tasks.size(), funcs.size());
             }
             else
             {
-                m_threads[m_current_thread++ % m_threads.size()]->run_detached(std::move(func));
+                // A worker keeps the batch on its own deque and lets the idle ones steal; an outside caller deals
+                // it out in contiguous slices, one inbox lock per worker. The first slice goes to first_worker if
+                // given, so equal batches land on the same workers every time (see first_touch.h).
+                if (auto *worker = local_thread::current(); worker && worker->is_worker_of(&m_threads))
+                {
+                    worker->submit_bulk(funcs);
+                }
+                else
+                {
+                    const size_t workers = m_threads.size();
+                    const size_t first = first_worker ? *first_worker : m_current_thread.fetch_add(1, std::memory_order_relaxed);
+                    size_t begin = 0;
+                    for (size_t i = 0; i < workers && begin < funcs.size(); ++i)
+                    {
+                        const size_t count = funcs.size() / workers + (i < funcs.size() % workers ? 1 : 0);
+                        m_threads[(first + i) % workers]->submit_bulk(funcs.subspan(begin, count));
+                        begin += count;
+                    }
+                }
             }
+            m_idle_event.notify_n(funcs.size());
         }
 
     private:
+        static std::vector<int> worker_cpus(const thread_pool_options &options, size_t num_threads)
+        {
+            std::vector<int> order;
+            switch (options.pinning)
+            {
+            case pinning_policy::none:
+                return {};
+            case pinning_policy::compact:
+                order = details::cpu_topology::instance().compact_order();
+                break;
+            case pinning_policy::scatter:
+                order = details::cpu_topology::instance().scatter_order();
+                break;
+            case pinning_policy::cpu_list:
+                order = options.cpus;
+                break;
+            }
+
+            std::vector<int> placement;
+            for (size_t i = 0; !order.empty() && i < num_threads; ++i)
+            {
+                placement.push_back(order[i % order.size()]);
+            }
+            return placement;
+        }
+
+        // The ring of workers after `worker`, with those on its own node moved to the front.
+        std::vector<size_t> steal_order(size_t worker) const
+        {
+            std::vector<size_t> order;
+            for (size_t i = 1; i < m_threads.size(); ++i)
+            {
+                order.push_back((worker + i) % m_threads.size());
+            }
+            std::ranges::stable_partition(order, [&](size_t victim)
+                                          { return m_threads[victim]->node() == m_threads[worker]->node(); });
+            return order;
+        }
+
+        static void stamp_latency(details::unique_function<void()> &func)
+        {
+            if (details::worker_metrics::sample_latency())
+            {
+                func = [func = std::move(func), submitted_at = details::metrics_clock::now()]() mutable
+                {
+                    if (auto *metrics = details::worker_metrics::current())
+                    {
+                        metrics->on_started(submitted_at);
+                    }
+                    func();
+                };
+            }
+        }
+
         std::atomic_bool m_shutdown;
-        std::vector<std::unique_ptr<thread_type>> m_threads;
 
-        mode_type<std::mutex, empty_type> m_tasks_mutex;
-        mode_type<std::condition_variable, empty_type> m_condition;
-        mode_type<std::queue<std::function<void()>>, empty_type> m_tasks;
+        // Declared before m_threads: the workers reference both until they are joined.
+        details::event_count m_idle_event;
+        mode_type<details::task_queue, empty_type> m_tasks;
+        [[no_unique_address]] mode_type<details::worker_metrics, empty_type> m_queue_metrics;
+
+        std::vector<std::unique_ptr<thread_type>> m_threads;
 
         mode_type<empty_type, std::atomic_uint64_t> m_current_thread;
     };
@@ -1,38 +1,328 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 namespace pot::utils
 {
-    template <typename DurationType, typename IterationCleanUpCallback, typename Func, typename... Args>
-    DurationType time_it(size_t n, IterationCleanUpCallback &&callback, Func &&func, Args &&...args)
-        requires std::invocable<Func, Args...> &&
-                 requires { { std::chrono::duration_cast<DurationType>(std::chrono::high_resolution_clock::now() - std::chrono::high_resolution_clock::now()) }; }
+    // Keeps the compiler from discarding `value` or the computation that produced it, without the store a
+    // volatile local costs.
+    template <typename T>
+    inline void do_not_optimize(const T &value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    template <typename T>
+    inline void do_not_optimize(T &value)
+    {
+        asm volatile("" : "+r,m"(value) : : "memory");
+    }
+
+    // Forces pending writes to memory to be treated as observable.
+    inline void clobber_memory()
+    {
+        asm volatile("" : : : "memory");
+    }
+
+    // Hardware counters of one measured region, summed over its iterations.
+    struct perf_counts
+    {
+        double cycles = 0;
+        double instructions = 0;
+        double cache_misses = 0;
+        double branch_misses = 0;
+    };
+
+    // Cycles, instructions, cache misses and branch misses of the calling thread in user space, read as one
+    // perf_event_open group. available() is false where the kernel refuses (non-Linux, perf_event_paranoid,
+    // containers); the benchmark then reports times only.
+    class perf_counter_group
+    {
+    public:
+        perf_counter_group()
+        {
+#if defined(__linux__)
+            constexpr std::array<uint64_t, 4> configs = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                                         PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+            for (size_t i = 0; i < configs.size(); ++i)
+            {
+                perf_event_attr attr{};
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.size = sizeof(attr);
+                attr.config = configs[i];
+                attr.disabled = i == 0;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                attr.read_format = PERF_FORMAT_GROUP;
+                const int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, i == 0 ? -1 : m_fds[0], 0));
+                if (fd < 0)
+                {
+                    close_all();
+                    return;
+                }
+                m_fds[i] = fd;
+            }
+#endif
+        }
+
+        ~perf_counter_group() { close_all(); }
+
+        perf_counter_group(const perf_counter_group &) = delete;
+        perf_counter_group &operator=(const perf_counter_group &) = delete;
+
+        [[nodiscard]] bool available() const noexcept { return m_fds[0] >= 0; }
+
+        void start()
+        {
+#if defined(__linux__)
+            ioctl(m_fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(m_fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+        }
+
+        perf_counts stop()
+        {
+            perf_counts counts;
+#if defined(__linux__)
+            ioctl(m_fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+            // PERF_FORMAT_GROUP: the number of events, then one value per event in creation order.
+            std::array<uint64_t, 1 + 4> values{};
+            if (read(m_fds[0], values.data(), sizeof(values)) == static_cast<ssize_t>(sizeof(values)))
+            {
+                counts = {static_cast<double>(values[1]), static_cast<double>(values[2]),
+                          static_cast<double>(values[3]), static_cast<double>(values[4])};
+            }
+#endif
+            return counts;
+        }
+
+    private:
+        void close_all()
+        {
+#if defined(__linux__)
+            for (int &fd : m_fds)
+            {
+                if (fd >= 0)
+                {
+                    close(fd);
+                    fd = -1;
+                }
+            }
+#endif
+        }
+
+        std::array<int, 4> m_fds{-1, -1, -1, -1};
+    };
+
+    struct benchmark_options
+    {
+        // Untimed calls before calibration, to fault in memory and warm caches and branch predictors.
+        size_t warm_up = 3;
+        size_t samples = 30;
+        // Without a fixed count, iterations per sample double until one sample takes at least min_sample_time,
+        // so that clock resolution and call overhead stay negligible.
+        std::optional<size_t> iterations{};
+        std::chrono::nanoseconds min_sample_time = std::chrono::milliseconds(1);
+        bool counters = false;
+    };
+
+    // Per-iteration statistics over the samples, in nanoseconds.
+    struct benchmark_result
+    {
+        size_t samples = 0;
+        size_t iterations_per_sample = 0;
+        double mean = 0;
+        double stddev = 0;
+        double min = 0;
+        double median = 0;
+        double p90 = 0;
+        double p99 = 0;
+        double max = 0;
+        // Per iteration, when requested and available.
+        std::optional<perf_counts> counters;
+    };
+
+    namespace details
+    {
+        struct no_clean_up
+        {
+            void operator()() const noexcept {}
+        };
+
+        inline double percentile(const std::vector<double> &sorted, double p)
+        {
+            const size_t index = static_cast<size_t>(std::lround(p * static_cast<double>(sorted.size() - 1)));
+            return sorted[std::min(index, sorted.size() - 1)];
+        }
+    }
+
+    // Statistics over per-iteration times (or any other per-operation cost) measured elsewhere.
+    inline benchmark_result summarize(std::vector<double> per_iteration, size_t iterations = 1)
+    {
+        std::sort(per_iteration.begin(), per_iteration.end());
+        benchmark_result result;
+        result.samples = per_iteration.size();
+        result.iterations_per_sample = iterations;
+        if (per_iteration.empty())
+        {
+            return result;
+        }
+
+        double sum = 0;
+        for (double value : per_iteration)
+        {
+            sum += value;
+        }
+        result.mean = sum / static_cast<double>(per_iteration.size());
+        double squares = 0;
+        for (double value : per_iteration)
+        {
+            squares += (value - result.mean) * (value - result.mean);
+        }
+        result.stddev = per_iteration.size() > 1 ? std::sqrt(squares / static_cast<double>(per_iteration.size() - 1)) : 0;
+        result.min = per_iteration.front();
+        result.median = details::percentile(per_iteration, 0.5);
+        result.p90 = details::percentile(per_iteration, 0.9);
+        result.p99 = details::percentile(per_iteration, 0.99);
+        result.max = per_iteration.back();
+        return result;
+    }
+
+    // Measures `func`. Each sample times `iterations` back-to-back calls; `clean_up` runs after every sample,
+    // outside the timed region, so with a clean-up each sample is a single call.
+    template <typename CleanUp, typename Func>
+        requires std::invocable<Func &> && std::invocable<CleanUp &>
+    benchmark_result benchmark(const benchmark_options &options, CleanUp &&clean_up, Func &&func)
     {
-        using clock_type = std::chrono::high_resolution_clock;
+        using clock_type = std::chrono::steady_clock;
+        constexpr bool has_clean_up = !std::is_same_v<std::remove_cvref_t<CleanUp>, details::no_clean_up>;
 
-        clock_type::duration duration{0};
+        for (size_t i = 0; i < options.warm_up; ++i)
+        {
+            std::invoke(func);
+            std::invoke(clean_up);
+        }
 
-        // execute function n times
-        for (size_t i = 0; i < n; i++)
+        auto run = [&](size_t iterations)
         {
             const auto start = clock_type::now();
-            std::invoke(std::forward<Func>(func), std::forward<Args>(args)...);
-            const auto end = clock_type::now();
-            duration += end - start;
+            for (size_t i = 0; i < iterations; ++i)
+            {
+                std::invoke(func);
+            }
+            clobber_memory();
+            return clock_type::now() - start;
+        };
+
+        size_t iterations = 1;
+        if (options.iterations)
+        {
+            iterations = std::max<size_t>(1, *options.iterations);
+        }
+        else if (!has_clean_up)
+        {
+            while (run(iterations) < options.min_sample_time && iterations < (size_t(1) << 30))
+            {
+                iterations *= 2;
+            }
+        }
 
-            std::invoke(std::forward<IterationCleanUpCallback>(callback));
+        std::optional<perf_counter_group> counters;
+        if (options.counters)
+        {
+            counters.emplace();
+        }
+        const bool counting = counters && counters->available();
+
+        std::vector<double> per_iteration;
+        per_iteration.reserve(options.samples);
+        perf_counts totals;
+        for (size_t s = 0; s < options.samples; ++s)
+        {
+            if (counting)
+            {
+                counters->start();
+            }
+            const auto duration = run(iterations);
+            if (counting)
+            {
+                const auto counts = counters->stop();
+                totals.cycles += counts.cycles;
+                totals.instructions += counts.instructions;
+                totals.cache_misses += counts.cache_misses;
+                totals.branch_misses += counts.branch_misses;
+            }
+            per_iteration.push_back(std::chrono::duration<double, std::nano>(duration).count() /
+                                    static_cast<double>(iterations));
+            std::invoke(clean_up);
+        }
+
+        auto result = summarize(std::move(per_iteration), iterations);
+        if (counting && options.samples > 0)
+        {
+            const double calls = static_cast<double>(options.samples * iterations);
+            result.counters = perf_counts{totals.cycles / calls, totals.instructions / calls,
+                                          totals.cache_misses / calls, totals.branch_misses / calls};
+        }
+        return result;
+    }
+
+    template <typename Func>
+        requires std::invocable<Func &>
+    benchmark_result benchmark(const benchmark_options &options, Func &&func)
+    {
+        return benchmark(options, details::no_clean_up{}, std::forward<Func>(func));
+    }
+
+    inline void print_result(std::string_view label, const benchmark_result &result)
+    {
+        std::printf("%-28.*s median %10.1f ns  p90 %10.1f  p99 %10.1f  stddev %8.1f  (%zu x %zu)\n",
+                    static_cast<int>(label.size()), label.data(), result.median, result.p90, result.p99,
+                    result.stddev, result.samples, result.iterations_per_sample);
+        if (result.counters)
+        {
+            const auto &c = *result.counters;
+            std::printf("%-28s cycles %10.0f  instructions %10.0f  IPC %.2f  cache misses %.1f  branch misses %.1f\n",
+                        "", c.cycles, c.instructions, c.cycles > 0 ? c.instructions / c.cycles : 0.0, c.cache_misses,
+                        c.branch_misses);
         }
+    }
 
-        return std::chrono::duration_cast<DurationType>(duration / n);
+    // Mean duration of n calls of func(args...), each timed on its own; callback runs after each call, untimed.
+    template <typename DurationType, typename IterationCleanUpCallback, typename Func, typename... Args>
+    DurationType time_it(size_t n, IterationCleanUpCallback &&callback, Func &&func, Args &&...args)
+        requires std::invocable<Func, Args...> &&
+                 requires { { std::chrono::duration_cast<DurationType>(std::chrono::steady_clock::duration{}) }; }
+    {
+        const auto result = benchmark({.warm_up = 0, .samples = n, .iterations = 1}, callback, [&]
+                                      { std::invoke(func, args...); });
+        return std::chrono::duration_cast<DurationType>(std::chrono::duration<double, std::nano>(result.mean));
     }
 
     template <typename DurationType, typename Func, typename... Args>
     DurationType time_it(Func &&func, Args &&...args)
         requires std::invocable<Func, Args...> &&
-                 requires { { std::chrono::duration_cast<DurationType>(std::chrono::high_resolution_clock::now() - std::chrono::high_resolution_clock::now()) }; }
+                 requires { { std::chrono::duration_cast<DurationType>(std::chrono::steady_clock::duration{}) }; }
     {
-        return time_it<DurationType, Func, Args...>(1, {}, std::forward<Func>(func), std::forward<Args>(args)...);
+        return time_it<DurationType>(1, [] {}, std::forward<Func>(func), std::forward<Args>(args)...);
     }
 
-}
\ No newline at end of file
+}
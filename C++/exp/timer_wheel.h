@@ -0,0 +1,306 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "unique_function.h"
+
+namespace pot::details
+{
+    // Called with false when its timer fires, or with true when the timer_service stops before it did.
+    using timer_callback = unique_function<void(bool cancelled)>;
+
+    // Hierarchical timing wheel: level l has slot_count slots of slot_count^l ticks each. Adding a timer and
+    // expiring one are O(1); a timer is moved down (cascaded) at most level_count - 1 times on its way to level 0.
+    // Timers further out than the wheel spans wait in the top level and are re-placed whenever it turns.
+    // Not thread-safe; timer_service owns one behind its mutex.
+    class timer_wheel
+    {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        static constexpr size_t slot_bits = 6;
+        static constexpr size_t slot_count = size_t(1) << slot_bits;
+        static constexpr size_t level_count = 4;
+
+        explicit timer_wheel(clock::duration tick, clock::time_point origin = clock::now())
+            : m_tick(tick), m_origin(origin) {}
+
+        // A timer never fires early: its deadline is rounded up to the next tick.
+        void add(clock::time_point deadline, timer_callback callback)
+        {
+            place({ceil_tick(deadline), std::move(callback)});
+            ++m_size;
+        }
+
+        // Moves the wheel up to `now`, appending the callbacks of every timer that came due.
+        void advance(clock::time_point now, std::vector<timer_callback> &expired)
+        {
+            const uint64_t target = floor_tick(now);
+            while (m_current < target)
+            {
+                // Ticks with nothing to cascade or expire are skipped outright.
+                const auto next = next_event_tick();
+                if (!next || *next > target)
+                {
+                    m_current = target;
+                    break;
+                }
+                m_current = *next;
+                process_tick(expired);
+            }
+        }
+
+        // When advance() next has something to do, or nullopt while the wheel is empty.
+        [[nodiscard]] std::optional<clock::time_point> next_wakeup() const
+        {
+            const auto next = next_event_tick();
+            if (!next)
+            {
+                return std::nullopt;
+            }
+            return m_origin + m_tick * static_cast<clock::rep>(*next);
+        }
+
+        // Empties the wheel, appending the callbacks of every timer still pending.
+        void take_all(std::vector<timer_callback> &pending)
+        {
+            for (auto &level : m_slots)
+            {
+                for (auto &slot : level)
+                {
+                    for (auto &timer : slot)
+                    {
+                        pending.push_back(std::move(timer.callback));
+                    }
+                    slot.clear();
+                }
+            }
+            m_size = 0;
+        }
+
+        [[nodiscard]] bool empty() const noexcept { return m_size == 0; }
+        [[nodiscard]] size_t size() const noexcept { return m_size; }
+
+    private:
+        struct entry
+        {
+            uint64_t expiry;
+            timer_callback callback;
+        };
+
+        static constexpr uint64_t slot_mask = slot_count - 1;
+
+        static constexpr uint64_t span(size_t level) noexcept { return uint64_t(1) << (slot_bits * level); }
+
+        uint64_t floor_tick(clock::time_point time) const noexcept
+        {
+            return time <= m_origin ? 0 : static_cast<uint64_t>((time - m_origin) / m_tick);
+        }
+
+        uint64_t ceil_tick(clock::time_point time) const noexcept
+        {
+            const uint64_t tick = floor_tick(time);
+            return m_origin + m_tick * static_cast<clock::rep>(tick) < time ? tick + 1 : tick;
+        }
+
+        void place(entry timer)
+        {
+            // Already due: fire on the next tick rather than in a slot that was processed.
+            const uint64_t expiry = std::max(timer.expiry, m_current + 1);
+            const uint64_t placement = std::min(expiry, m_current + span(level_count) - 1);
+            const uint64_t delta = placement - m_current;
+
+            size_t level = 0;
+            while (level + 1 < level_count && delta >= span(level + 1))
+            {
+                ++level;
+            }
+            m_slots[level][(placement >> (slot_bits * level)) & slot_mask].push_back(std::move(timer));
+        }
+
+        void process_tick(std::vector<timer_callback> &expired)
+        {
+            for (size_t level = level_count - 1; level > 0; --level)
+            {
+                if ((m_current & (span(level) - 1)) != 0)
+                {
+                    continue;
+                }
+                auto timers = std::move(m_slots[level][(m_current >> (slot_bits * level)) & slot_mask]);
+                for (auto &timer : timers)
+                {
+                    place(std::move(timer));
+                }
+            }
+
+            auto timers = std::move(m_slots[0][m_current & slot_mask]);
+            for (auto &timer : timers)
+            {
+                if (timer.expiry <= m_current)
+                {
+                    expired.push_back(std::move(timer.callback));
+                    --m_size;
+                }
+                else
+                {
+                    place(std::move(timer));
+                }
+            }
+        }
+
+        // The first tick after m_current at which a non-empty slot expires or cascades.
+        std::optional<uint64_t> next_event_tick() const
+        {
+            std::optional<uint64_t> next;
+            if (m_size == 0)
+            {
+                return next;
+            }
+            for (size_t level = 0; level < level_count; ++level)
+            {
+                const uint64_t base = m_current >> (slot_bits * level);
+                for (uint64_t k = 1; k <= slot_count; ++k)
+                {
+                    if (!m_slots[level][(base + k) & slot_mask].empty())
+                    {
+                        const uint64_t tick = (base + k) << (slot_bits * level);
+                        next = next ? std::min(*next, tick) : tick;
+                        break;
+                    }
+                }
+            }
+            return next;
+        }
+
+        clock::duration m_tick;
+        clock::time_point m_origin;
+        // Last tick processed.
+        uint64_t m_current = 0;
+        size_t m_size = 0;
+        std::array<std::array<std::vector<entry>, slot_count>, level_count> m_slots;
+    };
+
+    // A timer_wheel driven by one thread, started on the first timer. Callbacks run on that thread and should
+    // only hand work off (executor::run_detached), never block.
+    class timer_service
+    {
+    public:
+        using clock = timer_wheel::clock;
+
+        static constexpr std::chrono::milliseconds default_tick{1};
+
+        explicit timer_service(clock::duration tick = default_tick) : m_wheel(tick) {}
+
+        ~timer_service() { stop(); }
+
+        timer_service(const timer_service &) = delete;
+        timer_service &operator=(const timer_service &) = delete;
+
+        void schedule_at(clock::time_point deadline, timer_callback callback)
+        {
+            std::lock_guard lock(m_mutex);
+            if (m_stopped)
+            {
+                throw std::runtime_error("timer_service is stopped.");
+            }
+            if (!m_thread.joinable())
+            {
+                m_thread = std::jthread([this](std::stop_token stop_token)
+                                       { thread_loop(stop_token); });
+            }
+
+            m_wheel.add(deadline, std::move(callback));
+            if (deadline < m_wake_at)
+            {
+                m_rescheduled = true;
+                m_wake.notify_one();
+            }
+        }
+
+        // Joins the timer thread, then runs the callbacks of the timers still pending, cancelled, on the calling
+        // thread: whatever waits on them is released instead of left hanging.
+        void stop()
+        {
+            std::jthread thread;
+            {
+                std::lock_guard lock(m_mutex);
+                m_stopped = true;
+                thread = std::move(m_thread);
+            }
+            if (thread.joinable())
+            {
+                thread.request_stop();
+                thread.join();
+            }
+
+            std::vector<timer_callback> pending;
+            {
+                std::lock_guard lock(m_mutex);
+                m_wheel.take_all(pending);
+            }
+            for (auto &callback : pending)
+            {
+                callback(true);
+            }
+        }
+
+        [[nodiscard]] size_t pending() const
+        {
+            std::lock_guard lock(m_mutex);
+            return m_wheel.size();
+        }
+
+    private:
+        void thread_loop(std::stop_token stop_token)
+        {
+            std::vector<timer_callback> expired;
+            std::unique_lock lock(m_mutex);
+            while (!stop_token.stop_requested())
+            {
+                m_wheel.advance(clock::now(), expired);
+                if (!expired.empty())
+                {
+                    lock.unlock();
+                    for (auto &callback : expired)
+                    {
+                        callback(false);
+                    }
+                    expired.clear();
+                    lock.lock();
+                    continue;
+                }
+
+                m_rescheduled = false;
+                if (const auto wakeup = m_wheel.next_wakeup())
+                {
+                    m_wake_at = *wakeup;
+                    m_wake.wait_until(lock, stop_token, m_wake_at, [&]
+                                      { return m_rescheduled; });
+                }
+                else
+                {
+                    m_wake_at = clock::time_point::max();
+                    m_wake.wait(lock, stop_token, [&]
+                                { return m_rescheduled; });
+                }
+            }
+        }
+
+        mutable std::mutex m_mutex;
+        std::condition_variable_any m_wake;
+        timer_wheel m_wheel;
+        // When the timer thread is due to wake up by itself; earlier timers have to wake it.
+        clock::time_point m_wake_at = clock::time_point::max();
+        bool m_rescheduled = false;
+        bool m_stopped = false;
+        std::jthread m_thread;
+    };
+}
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace pot::details
+{
+    struct cpu_info
+    {
+        int id = 0;
+        int package = 0;
+        int core = 0;
+        // NUMA node, or the package on machines that do not report nodes.
+        int node = 0;
+    };
+
+    // The CPUs this process may run on and where they sit. Read once from sysfs on Linux; elsewhere every CPU
+    // is reported as its own core on a single node.
+    class cpu_topology
+    {
+    public:
+        explicit cpu_topology(std::vector<cpu_info> cpus) : m_cpus(std::move(cpus))
+        {
+            std::ranges::sort(m_cpus, {}, [](const cpu_info &cpu)
+                              { return std::tuple(cpu.node, cpu.package, cpu.core, cpu.id); });
+        }
+
+        static const cpu_topology &instance()
+        {
+            static const cpu_topology topology(detect());
+            return topology;
+        }
+
+        [[nodiscard]] const std::vector<cpu_info> &cpus() const noexcept { return m_cpus; }
+
+        [[nodiscard]] int node_of(int cpu) const noexcept
+        {
+            const auto it = std::ranges::find(m_cpus, cpu, &cpu_info::id);
+            return it == m_cpus.end() ? 0 : it->node;
+        }
+
+        // Fills one node before moving to the next, keeping the hardware threads of a core next to each other.
+        [[nodiscard]] std::vector<int> compact_order() const
+        {
+            std::vector<int> order;
+            order.reserve(m_cpus.size());
+            for (const auto &cpu : m_cpus)
+            {
+                order.push_back(cpu.id);
+            }
+            return order;
+        }
+
+        // Deals CPUs out to the nodes in turn, and within a node spreads over distinct cores before reusing one.
+        [[nodiscard]] std::vector<int> scatter_order() const
+        {
+            std::vector<std::vector<const cpu_info *>> nodes;
+            for (const auto &cpu : m_cpus)
+            {
+                if (nodes.empty() || nodes.back().front()->node != cpu.node)
+                {
+                    nodes.emplace_back();
+                }
+                nodes.back().push_back(&cpu);
+            }
+            for (auto &node : nodes)
+            {
+                // Stable: the n-th hardware thread of every core comes before any (n+1)-th one.
+                std::vector<int> rank(node.size(), 0);
+                for (size_t i = 1; i < node.size(); ++i)
+                {
+                    const bool same_core = node[i]->package == node[i - 1]->package && node[i]->core == node[i - 1]->core;
+                    rank[i] = same_core ? rank[i - 1] + 1 : 0;
+                }
+                std::vector<size_t> indices(node.size());
+                for (size_t i = 0; i < indices.size(); ++i)
+                {
+                    indices[i] = i;
+                }
+                std::ranges::stable_sort(indices, {}, [&](size_t i)
+                                         { return rank[i]; });
+
+                std::vector<const cpu_info *> spread;
+                spread.reserve(node.size());
+                for (size_t i : indices)
+                {
+                    spread.push_back(node[i]);
+                }
+                node = std::move(spread);
+            }
+
+            std::vector<int> order;
+            order.reserve(m_cpus.size());
+            for (size_t round = 0; order.size() < m_cpus.size(); ++round)
+            {
+                for (const auto &node : nodes)
+                {
+                    if (round < node.size())
+                    {
+                        order.push_back(node[round]->id);
+                    }
+                }
+            }
+            return order;
+        }
+
+    private:
+        static std::vector<cpu_info> detect()
+        {
+            std::vector<cpu_info> cpus;
+#if defined(__linux__)
+            cpu_set_t allowed;
+            CPU_ZERO(&allowed);
+            if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+            {
+                for (int id = 0; id < CPU_SETSIZE; ++id)
+                {
+                    if (!CPU_ISSET(id, &allowed))
+                    {
+                        continue;
+                    }
+
+                    const std::filesystem::path cpu_path = "/sys/devices/system/cpu/cpu" + std::to_string(id);
+                    cpu_info cpu{.id = id,
+                                 .package = read_int(cpu_path / "topology/physical_package_id", 0),
+                                 .core = read_int(cpu_path / "topology/core_id", id)};
+                    cpu.node = cpu.package;
+
+                    std::error_code error;
+                    for (const auto &entry : std::filesystem::directory_iterator(cpu_path, error))
+                    {
+                        const std::string name = entry.path().filename().string();
+                        if (name.starts_with("node") && name.size() > 4 && std::isdigit(static_cast<unsigned char>(name[4])))
+                        {
+                            cpu.node = std::stoi(name.substr(4));
+                            break;
+                        }
+                    }
+                    cpus.push_back(cpu);
+                }
+            }
+#endif
+            if (cpus.empty())
+            {
+                const int count = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+                for (int id = 0; id < count; ++id)
+                {
+                    cpus.push_back({.id = id, .package = 0, .core = id, .node = 0});
+                }
+            }
+            return cpus;
+        }
+
+        static int read_int(const std::filesystem::path &path, int fallback)
+        {
+            int value = fallback;
+            if (std::FILE *file = std::fopen(path.c_str(), "r"))
+            {
+                if (std::fscanf(file, "%d", &value) != 1)
+                {
+                    value = fallback;
+                }
+                std::fclose(file);
+            }
+            return value;
+        }
+
+        std::vector<cpu_info> m_cpus;
+    };
+
+    // Restricts a running thread to one CPU. Returns false where affinity is not supported or the CPU is not usable.
+    inline bool pin_thread(std::thread::native_handle_type handle, int cpu)
+    {
+#if defined(__linux__)
+        if (cpu < 0 || cpu >= CPU_SETSIZE)
+        {
+            return false;
+        }
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return pthread_setaffinity_np(handle, sizeof(set), &set) == 0;
+#else
+        (void)handle;
+        (void)cpu;
+        return false;
+#endif
+    }
+
+    // NUMA node of the CPU the calling thread is running on right now.
+    inline int current_node()
+    {
+#if defined(__linux__)
+        const int cpu = sched_getcpu();
+        return cpu < 0 ? 0 : cpu_topology::instance().node_of(cpu);
+#else
+        return 0;
+#endif
+    }
+}
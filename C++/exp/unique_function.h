@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "small_object_pool.h"
+
+namespace pot::details
+{
+    template <typename Signature>
+    class unique_function;
+
+    // Move-only replacement for std::function. Callables up to inline_size bytes live inside the
+    // object itself, so a queue of unique_function stores its jobs inline; bigger ones go to the small object pool.
+    template <typename R, typename... Args>
+    class unique_function<R(Args...)>
+    {
+    public:
+        static constexpr std::size_t inline_size = 6 * sizeof(void *);
+
+        unique_function() noexcept = default;
+        unique_function(std::nullptr_t) noexcept {}
+
+        template <typename Func>
+            requires(!std::is_same_v<std::remove_cvref_t<Func>, unique_function> &&
+                     std::is_invocable_r_v<R, std::decay_t<Func> &, Args...>)
+        unique_function(Func &&func)
+        {
+            using functor_type = std::decay_t<Func>;
+
+            if constexpr (stored_inline<functor_type>)
+            {
+                ::new (static_cast<void *>(m_storage)) functor_type(std::forward<Func>(func));
+            }
+            else
+            {
+                ::new (static_cast<void *>(m_storage)) functor_type *(pool_new<functor_type>(std::forward<Func>(func)));
+            }
+            m_vtable = &vtable_for<functor_type>;
+        }
+
+        unique_function(unique_function &&other) noexcept
+        {
+            if (other.m_vtable)
+            {
+                other.m_vtable->relocate(other.m_storage, m_storage);
+                m_vtable = std::exchange(other.m_vtable, nullptr);
+            }
+        }
+
+        unique_function &operator=(unique_function &&other) noexcept
+        {
+            if (this != &other)
+            {
+                reset();
+                if (other.m_vtable)
+                {
+                    other.m_vtable->relocate(other.m_storage, m_storage);
+                    m_vtable = std::exchange(other.m_vtable, nullptr);
+                }
+            }
+            return *this;
+        }
+
+        unique_function &operator=(std::nullptr_t) noexcept
+        {
+            reset();
+            return *this;
+        }
+
+        unique_function(const unique_function &) = delete;
+        unique_function &operator=(const unique_function &) = delete;
+
+        ~unique_function() { reset(); }
+
+        R operator()(Args... args)
+        {
+            return m_vtable->invoke(m_storage, std::forward<Args>(args)...);
+        }
+
+        explicit operator bool() const noexcept { return m_vtable != nullptr; }
+
+    private:
+        struct vtable
+        {
+            R (*invoke)(void *, Args &&...);
+            void (*relocate)(void *from, void *to) noexcept;
+            void (*destroy)(void *) noexcept;
+        };
+
+        template <typename Functor>
+        static constexpr bool stored_inline = sizeof(Functor) <= inline_size &&
+                                              alignof(Functor) <= alignof(std::max_align_t) &&
+                                              std::is_nothrow_move_constructible_v<Functor>;
+
+        template <typename Functor>
+        static Functor &target(void *storage) noexcept
+        {
+            if constexpr (stored_inline<Functor>)
+            {
+                return *std::launder(static_cast<Functor *>(storage));
+            }
+            else
+            {
+                return **std::launder(static_cast<Functor **>(storage));
+            }
+        }
+
+        template <typename Functor>
+        static constexpr vtable vtable_for{
+            [](void *storage, Args &&...args) -> R
+            {
+                if constexpr (std::is_void_v<R>)
+                {
+                    std::invoke(target<Functor>(storage), std::forward<Args>(args)...);
+                }
+                else
+                {
+                    return std::invoke(target<Functor>(storage), std::forward<Args>(args)...);
+                }
+            },
+            [](void *from, void *to) noexcept
+            {
+                if constexpr (stored_inline<Functor>)
+                {
+                    Functor &source = target<Functor>(from);
+                    ::new (to) Functor(std::move(source));
+                    source.~Functor();
+                }
+                else
+                {
+                    ::new (to) Functor *(&target<Functor>(from));
+                }
+            },
+            [](void *storage) noexcept
+            {
+                if constexpr (stored_inline<Functor>)
+                {
+                    target<Functor>(storage).~Functor();
+                }
+                else
+                {
+                    pool_delete(&target<Functor>(storage));
+                }
+            }};
+
+        void reset() noexcept
+        {
+            if (m_vtable)
+            {
+                std::exchange(m_vtable, nullptr)->destroy(m_storage);
+            }
+        }
+
+        alignas(std::max_align_t) std::byte m_storage[inline_size];
+        const vtable *m_vtable{nullptr};
+    };
+}
@@ -1,27 +1,516 @@
 #pragma once
 
-#include "task_coroutine.h"
+#include <array>
+#include <atomic>
+#include <coroutine>
+#include <exception>
 #include <iterator>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <stop_token>
+#include <tuple>
+#include <variant>
 #include <vector>
 
-#include <iostream>
+#include "task_coroutine.h"
+#include "cancellation.h"
+#include "executor.h"
+
 namespace pot
 {
+    template <typename T>
+    struct when_any_result
+    {
+        size_t index;
+        T value;
+    };
+
+    template <>
+    struct when_any_result<void>
+    {
+        size_t index;
+    };
+} // namespace pot
+
+namespace pot::details
+{
+    // Children and the awaiter each arrive once; whoever arrives last resumes the awaiter, so it runs exactly once.
+    class when_all_counter
+    {
+    public:
+        explicit when_all_counter(size_t count) noexcept : m_count(count + 1) {}
+
+        void set_awaiter(std::coroutine_handle<> awaiter) noexcept { m_awaiter = awaiter; }
+
+        std::coroutine_handle<> arrive() noexcept
+        {
+            return m_count.fetch_sub(1, std::memory_order_acq_rel) == 1 ? m_awaiter : std::noop_coroutine();
+        }
+
+    private:
+        std::atomic<size_t> m_count;
+        std::coroutine_handle<> m_awaiter;
+    };
+
+    class when_all_waiter
+    {
+    public:
+        struct promise_type : pooled_frame
+        {
+            when_all_counter *m_counter = nullptr;
+
+            when_all_waiter get_return_object() noexcept
+            {
+                return when_all_waiter{std::coroutine_handle<promise_type>::from_promise(*this)};
+            }
+
+            std::suspend_always initial_suspend() noexcept { return {}; }
+
+            auto final_suspend() noexcept
+            {
+                struct final_awaiter
+                {
+                    bool await_ready() const noexcept { return false; }
+                    std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+                    {
+                        return handle.promise().m_counter->arrive();
+                    }
+                    void await_resume() const noexcept {}
+                };
+                return final_awaiter{};
+            }
+
+            void return_void() noexcept {}
+            void unhandled_exception() noexcept { std::terminate(); }
+        };
+
+        when_all_waiter(when_all_waiter &&other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+        when_all_waiter &operator=(when_all_waiter &&) = delete;
+
+        ~when_all_waiter()
+        {
+            if (m_handle)
+            {
+                m_handle.destroy();
+            }
+        }
+
+        void start(when_all_counter &counter)
+        {
+            m_handle.promise().m_counter = &counter;
+            m_handle.resume();
+        }
+
+    private:
+        explicit when_all_waiter(std::coroutine_handle<promise_type> handle) noexcept : m_handle(handle) {}
+
+        std::coroutine_handle<promise_type> m_handle;
+    };
+
+    // The waiter never touches the result, so failures are rethrown by whoever collects it.
+    template <typename Task>
+    when_all_waiter make_when_all_waiter(Task &task)
+    {
+        co_await task.when_ready();
+    }
+
+    class when_all_awaitable
+    {
+    public:
+        explicit when_all_awaitable(std::span<when_all_waiter> waiters) noexcept
+            : m_waiters(waiters), m_counter(waiters.size()) {}
+
+        bool await_ready() const noexcept { return m_waiters.empty(); }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter)
+        {
+            m_counter.set_awaiter(awaiter);
+            for (auto &waiter : m_waiters)
+            {
+                waiter.start(m_counter);
+            }
+            return m_counter.arrive();
+        }
+
+        void await_resume() const noexcept {}
+
+    private:
+        std::span<when_all_waiter> m_waiters;
+        when_all_counter m_counter;
+    };
+
+    template <typename Task>
+    using when_all_element_t = std::conditional_t<std::is_void_v<traits::task_value_type_t<Task>>,
+                                                  std::monostate, traits::task_value_type_t<Task>>;
+
+    template <typename Task>
+    when_all_element_t<Task> get_when_all_element(Task &task)
+    {
+        if constexpr (std::is_void_v<traits::task_value_type_t<Task>>)
+        {
+            task.get();
+            return {};
+        }
+        else
+        {
+            return task.get();
+        }
+    }
+
+    template <typename Task, typename T = traits::task_value_type_t<Task>>
+    coroutines::task<std::conditional_t<std::is_void_v<T>, void, std::vector<T>>> when_all_impl(std::vector<Task> tasks)
+    {
+        std::vector<when_all_waiter> waiters;
+        waiters.reserve(tasks.size());
+        for (auto &task : tasks)
+        {
+            waiters.push_back(make_when_all_waiter(task));
+        }
+
+        co_await when_all_awaitable(waiters);
+
+        if constexpr (std::is_void_v<T>)
+        {
+            for (auto &task : tasks)
+            {
+                task.get();
+            }
+        }
+        else
+        {
+            std::vector<T> results;
+            results.reserve(tasks.size());
+            for (auto &task : tasks)
+            {
+                results.push_back(task.get());
+            }
+            co_return results;
+        }
+    }
+
+    // Tasks shared between detached waiters and an awaiter that is resumed exactly once, possibly before all
+    // of them finished: by the first one to finish (when_any) or by cancellation (when_all with a token).
+    template <typename Task>
+    struct detached_join_state
+    {
+        static constexpr uint32_t awaiter_suspended = 1;
+        static constexpr uint32_t resolved = 2;
+
+        explicit detached_join_state(std::vector<Task> tasks) : m_tasks(std::move(tasks)) {}
+
+        // True for the one caller that gets to resume the awaiter.
+        bool try_resolve() noexcept { return !m_has_resolver.exchange(true, std::memory_order_acq_rel); }
+
+        // Called by the resolver once it has recorded the outcome. A resolver that is not one of the tasks (a
+        // stop callback, on whatever thread requested the stop) passes on_executor to hand the awaiter back to
+        // the executor it suspended on instead of running it inline.
+        void resume_awaiter(bool on_executor = false)
+        {
+            if (m_flags.fetch_or(resolved, std::memory_order_acq_rel) & awaiter_suspended)
+            {
+                if (on_executor && m_executor)
+                {
+                    m_executor->run_detached([handle = m_awaiter]
+                                             { handle.resume(); });
+                }
+                else
+                {
+                    m_awaiter.resume();
+                }
+            }
+        }
+
+        std::vector<Task> m_tasks;
+        std::atomic<bool> m_has_resolver{false};
+        std::atomic<uint32_t> m_flags{0};
+        std::coroutine_handle<> m_awaiter;
+        executor *m_executor = nullptr;
+    };
+
+    template <typename Task>
+    struct when_any_state : detached_join_state<Task>
+    {
+        using detached_join_state<Task>::detached_join_state;
+
+        size_t m_winner = 0;
+    };
+
+    template <typename Task>
+    struct cancellable_when_all_state : detached_join_state<Task>
+    {
+        explicit cancellable_when_all_state(std::vector<Task> tasks)
+            : detached_join_state<Task>(std::move(tasks)), m_remaining(this->m_tasks.size()) {}
+
+        std::atomic<size_t> m_remaining;
+        bool m_cancelled = false;
+    };
+
+    // Destroys its own frame on completion: losers of a when_any keep running after the awaiter has moved on.
+    class detached_waiter
+    {
+    public:
+        struct promise_type : pooled_frame
+        {
+            detached_waiter get_return_object() noexcept
+            {
+                return detached_waiter{std::coroutine_handle<promise_type>::from_promise(*this)};
+            }
+
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() noexcept {}
+            void unhandled_exception() noexcept { std::terminate(); }
+        };
+
+        detached_waiter(detached_waiter &&other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+        detached_waiter &operator=(detached_waiter &&) = delete;
+
+        ~detached_waiter()
+        {
+            if (m_handle)
+            {
+                m_handle.destroy();
+            }
+        }
+
+        void start() &&
+        {
+            std::exchange(m_handle, {}).resume();
+        }
+
+    private:
+        explicit detached_waiter(std::coroutine_handle<promise_type> handle) noexcept : m_handle(handle) {}
+
+        std::coroutine_handle<promise_type> m_handle;
+    };
+
+    template <typename Task>
+    detached_waiter make_when_any_waiter(std::shared_ptr<when_any_state<Task>> state, size_t index)
+    {
+        co_await state->m_tasks[index].when_ready();
+
+        if (state->try_resolve())
+        {
+            state->m_winner = index;
+            state->resume_awaiter();
+        }
+    }
+
+    template <typename Task>
+    detached_waiter make_cancellable_when_all_waiter(std::shared_ptr<cancellable_when_all_state<Task>> state, size_t index,
+                                                     std::stop_token token)
+    {
+        // A lazy task nobody started is not worth starting once the whole join was cancelled; started ones are
+        // awaited regardless, because their frames only go away once they finish.
+        auto &task = state->m_tasks[index];
+        if (!token.stop_requested() || task.started())
+        {
+            co_await task.when_ready();
+        }
+
+        if (state->m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1 && state->try_resolve())
+        {
+            state->resume_awaiter();
+        }
+    }
+
+    // Starts the waiters and suspends until the state is resolved.
+    template <typename State, typename StartWaiters>
+    class detached_join_awaitable
+    {
+    public:
+        detached_join_awaitable(std::shared_ptr<State> state, StartWaiters start_waiters) noexcept
+            : m_state(std::move(state)), m_start_waiters(std::move(start_waiters)) {}
+
+        bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(std::coroutine_handle<> awaiter)
+        {
+            m_state->m_awaiter = awaiter;
+            m_state->m_executor = executor::current();
+            m_start_waiters();
+            // A resolver that showed up while the waiters were starting did not resume us, so carry on ourselves.
+            return !(m_state->m_flags.fetch_or(State::awaiter_suspended, std::memory_order_acq_rel) & State::resolved);
+        }
+
+        void await_resume() const noexcept {}
+
+    private:
+        std::shared_ptr<State> m_state;
+        StartWaiters m_start_waiters;
+    };
+
+    template <typename Task, typename T = traits::task_value_type_t<Task>>
+    coroutines::task<when_any_result<T>> when_any_impl(std::vector<Task> tasks)
+    {
+        if (tasks.empty())
+        {
+            throw std::invalid_argument("when_any requires at least one task.");
+        }
+
+        auto state = std::make_shared<when_any_state<Task>>(std::move(tasks));
+        detached_join_awaitable join(state, [state]
+                                     {
+            for (size_t i = 0; i < state->m_tasks.size(); ++i)
+            {
+                make_when_any_waiter(state, i).start();
+            } });
+        co_await join;
+
+        auto &winner = state->m_tasks[state->m_winner];
+        if constexpr (std::is_void_v<T>)
+        {
+            winner.get();
+            co_return when_any_result<void>{state->m_winner};
+        }
+        else
+        {
+            co_return when_any_result<T>{state->m_winner, winner.get()};
+        }
+    }
+
+    // The state outlives the callback: the joining coroutine holds both and drops the callback first.
+    template <typename Task>
+    struct cancel_when_all
+    {
+        cancellable_when_all_state<Task> *m_state;
+
+        void operator()() const
+        {
+            if (m_state->try_resolve())
+            {
+                m_state->m_cancelled = true;
+                m_state->resume_awaiter(true);
+            }
+        }
+    };
+
+    // Resolved by whichever comes first, the last task finishing or the token being cancelled. On cancellation
+    // the awaiter gets operation_cancelled straight away and the tasks finish in the background.
+    template <typename Task, typename T = traits::task_value_type_t<Task>>
+    coroutines::task<std::conditional_t<std::is_void_v<T>, void, std::vector<T>>> cancellable_when_all_impl(std::vector<Task> tasks,
+                                                                                                           std::stop_token token)
+    {
+        auto state = std::make_shared<cancellable_when_all_state<Task>>(std::move(tasks));
+        // Registered before the waiters start, so a cancellation that already happened resolves the state first.
+        std::optional<std::stop_callback<cancel_when_all<Task>>> cancel_callback(std::in_place, token,
+                                                                                 cancel_when_all<Task>{state.get()});
+
+        detached_join_awaitable join(state, [state, token]
+                                     {
+            if (state->m_tasks.empty() && state->try_resolve())
+            {
+                state->resume_awaiter();
+            }
+            for (size_t i = 0; i < state->m_tasks.size(); ++i)
+            {
+                make_cancellable_when_all_waiter(state, i, token).start();
+            } });
+        co_await join;
+        cancel_callback.reset();
+
+        if (state->m_cancelled)
+        {
+            throw operation_cancelled();
+        }
+        if constexpr (std::is_void_v<T>)
+        {
+            for (auto &task : state->m_tasks)
+            {
+                task.get();
+            }
+        }
+        else
+        {
+            std::vector<T> results;
+            results.reserve(state->m_tasks.size());
+            for (auto &task : state->m_tasks)
+            {
+                results.push_back(task.get());
+            }
+            co_return results;
+        }
+    }
+
     template <typename Iterator>
-    pot::coroutines::task<void> when_all(Iterator begin, Iterator end)
-        requires std::forward_iterator<Iterator>
+    auto take_tasks(Iterator begin, Iterator end)
     {
+        std::vector<std::iter_value_t<Iterator>> tasks;
+        tasks.reserve(std::distance(begin, end));
         for (auto it = begin; it != end; ++it)
         {
-            co_await std::move(*it);
+            tasks.push_back(std::move(*it));
         }
+        return tasks;
+    }
+} // namespace pot::details
+
+namespace pot
+{
+    // Moves the tasks out of [begin, end), runs them all concurrently and resumes the awaiter once the last one
+    // finished. Results come back in input order; the first failure (in input order) is rethrown.
+    template <typename Iterator>
+        requires std::forward_iterator<Iterator> && traits::concepts::is_task<std::iter_value_t<Iterator>>
+    auto when_all(Iterator begin, Iterator end)
+    {
+        return details::when_all_impl(details::take_tasks(begin, end));
+    }
+
+    // The container overloads take an rvalue, so handing the tasks over is spelled std::move(tasks) at the call.
+    template <typename Container>
+        requires std::ranges::forward_range<Container> && (!std::is_lvalue_reference_v<Container>) &&
+                 (!traits::concepts::is_task<std::remove_cvref_t<Container>>)
+    auto when_all(Container &&tasks)
+    {
+        return when_all(std::ranges::begin(tasks), std::ranges::end(tasks));
+    }
+
+    // As above, but once the token is cancelled the join fails with operation_cancelled without waiting for the
+    // stragglers, and tasks that were never started are not started any more. Pass the same token to the tasks
+    // (e.g. through executor::run) so that the ones still queued are dropped too.
+    template <typename Iterator>
+        requires std::forward_iterator<Iterator> && traits::concepts::is_task<std::iter_value_t<Iterator>>
+    auto when_all(Iterator begin, Iterator end, std::stop_token token)
+    {
+        return details::cancellable_when_all_impl(details::take_tasks(begin, end), std::move(token));
+    }
+
+    template <typename Container>
+        requires std::ranges::forward_range<Container> && (!std::is_lvalue_reference_v<Container>) &&
+                 (!traits::concepts::is_task<std::remove_cvref_t<Container>>)
+    auto when_all(Container &&tasks, std::stop_token token)
+    {
+        return when_all(std::ranges::begin(tasks), std::ranges::end(tasks), std::move(token));
+    }
+
+    // Void results are reported as std::monostate so they keep their place in the tuple.
+    template <typename... Tasks>
+        requires(sizeof...(Tasks) > 0 && (traits::concepts::is_task<Tasks> && ...))
+    coroutines::task<std::tuple<details::when_all_element_t<Tasks>...>> when_all(Tasks... tasks)
+    {
+        std::array<details::when_all_waiter, sizeof...(Tasks)> waiters{details::make_when_all_waiter(tasks)...};
+        co_await details::when_all_awaitable(waiters);
+
+        co_return std::tuple<details::when_all_element_t<Tasks>...>{details::get_when_all_element(tasks)...};
+    }
 
-        co_return;
+    // Resolves with the index and result of the first task to finish. The others keep running to completion
+    // in the background and are released by whichever of them finishes last.
+    template <typename Iterator>
+        requires std::forward_iterator<Iterator> && traits::concepts::is_task<std::iter_value_t<Iterator>>
+    auto when_any(Iterator begin, Iterator end)
+    {
+        return details::when_any_impl(details::take_tasks(begin, end));
     }
 
-    template <template <class, class...> class Container, typename FutureType, typename... OtherTypes>
-    pot::coroutines::task<void> when_all(Container<FutureType, OtherTypes...> &futures)
+    template <typename Container>
+        requires std::ranges::forward_range<Container> && (!std::is_lvalue_reference_v<Container>) &&
+                 (!traits::concepts::is_task<std::remove_cvref_t<Container>>)
+    auto when_any(Container &&tasks)
     {
-        co_return co_await when_all(std::begin(futures), std::end(futures));
+        return when_any(std::ranges::begin(tasks), std::ranges::end(tasks));
     }
 } // namespace pot
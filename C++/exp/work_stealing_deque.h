@@ -0,0 +1,150 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+#include "cache_line.h"
+
+namespace pot::details
+{
+    // Chase-Lev work-stealing deque, with the memory orderings from
+    // Le, Pop, Cohen, Zappa Nardelli, "Correct and Efficient Work-Stealing for Weak Memory Models".
+    // push()/pop() may only be called by the owning worker and work on the bottom (LIFO),
+    // steal() may be called by any thread and takes from the top (FIFO).
+    template <typename T>
+        requires std::is_trivially_copyable_v<T>
+    class work_stealing_deque
+    {
+        class ring_buffer
+        {
+        public:
+            explicit ring_buffer(int64_t capacity)
+                : m_capacity(capacity), m_mask(capacity - 1), m_data(std::make_unique<std::atomic<T>[]>(capacity)) {}
+
+            [[nodiscard]] int64_t capacity() const noexcept { return m_capacity; }
+
+            T load(int64_t index) const noexcept
+            {
+                return m_data[index & m_mask].load(std::memory_order_relaxed);
+            }
+
+            void store(int64_t index, T value) noexcept
+            {
+                m_data[index & m_mask].store(value, std::memory_order_relaxed);
+            }
+
+            std::unique_ptr<ring_buffer> grow(int64_t bottom, int64_t top) const
+            {
+                auto result = std::make_unique<ring_buffer>(m_capacity * 2);
+                for (int64_t i = top; i < bottom; ++i)
+                {
+                    result->store(i, load(i));
+                }
+                return result;
+            }
+
+        private:
+            int64_t m_capacity;
+            int64_t m_mask;
+            std::unique_ptr<std::atomic<T>[]> m_data;
+        };
+
+    public:
+        explicit work_stealing_deque(int64_t capacity = 1024)
+        {
+            assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+            m_buffers.push_back(std::make_unique<ring_buffer>(capacity));
+            m_buffer.store(m_buffers.back().get(), std::memory_order_relaxed);
+        }
+
+        work_stealing_deque(const work_stealing_deque &) = delete;
+        work_stealing_deque &operator=(const work_stealing_deque &) = delete;
+
+        void push(T value)
+        {
+            const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+            const int64_t top = m_top.load(std::memory_order_acquire);
+            ring_buffer *buffer = m_buffer.load(std::memory_order_relaxed);
+
+            if (bottom - top > buffer->capacity() - 1)
+            {
+                // Thieves may still be reading the old buffer, so it is retired rather than freed.
+                m_buffers.push_back(buffer->grow(bottom, top));
+                buffer = m_buffers.back().get();
+                m_buffer.store(buffer, std::memory_order_release);
+            }
+
+            buffer->store(bottom, value);
+            m_bottom.store(bottom + 1, std::memory_order_release);
+        }
+
+        std::optional<T> pop()
+        {
+            const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+            ring_buffer *buffer = m_buffer.load(std::memory_order_relaxed);
+            m_bottom.store(bottom, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t top = m_top.load(std::memory_order_relaxed);
+
+            if (top > bottom)
+            {
+                m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                return std::nullopt;
+            }
+
+            std::optional<T> result = buffer->load(bottom);
+            if (top == bottom)
+            {
+                // Last element: race the thieves for it.
+                if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                {
+                    result.reset();
+                }
+                m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            }
+            return result;
+        }
+
+        std::optional<T> steal()
+        {
+            int64_t top = m_top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const int64_t bottom = m_bottom.load(std::memory_order_acquire);
+
+            if (top >= bottom)
+            {
+                return std::nullopt;
+            }
+
+            const T value = m_buffer.load(std::memory_order_acquire)->load(top);
+            if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            {
+                return std::nullopt;
+            }
+            return value;
+        }
+
+        [[nodiscard]] bool empty() const noexcept
+        {
+            return size() == 0;
+        }
+
+        [[nodiscard]] size_t size() const noexcept
+        {
+            const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+            const int64_t top = m_top.load(std::memory_order_relaxed);
+            return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+        }
+
+    private:
+        alignas(cache_line_size) std::atomic<int64_t> m_top{0};
+        alignas(cache_line_size) std::atomic<int64_t> m_bottom{0};
+        alignas(cache_line_size) std::atomic<ring_buffer *> m_buffer{nullptr};
+        std::vector<std::unique_ptr<ring_buffer>> m_buffers;
+    };
+}
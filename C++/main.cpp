@@ -7,38 +7,7 @@
 #include <random>
 #include <functional>
 
-namespace utils
-{
-    template <typename DurationType, typename IterationCleanUpCallback, typename Func, typename... Args>
-    DurationType time_it(size_t n, IterationCleanUpCallback &&callback, Func &&func, Args &&...args)
-        requires std::invocable<Func, Args...> &&
-                 requires { { std::chrono::duration_cast<DurationType>(std::chrono::high_resolution_clock::now() - std::chrono::high_resolution_clock::now()) }; }
-    {
-        using clock_type = std::chrono::high_resolution_clock;
-
-        clock_type::duration duration{0};
-
-        for (size_t i = 0; i < n; i++)
-        {
-            const auto start = clock_type::now();
-            std::invoke(std::forward<Func>(func), std::forward<Args>(args)...);
-            const auto end = clock_type::now();
-            duration += end - start;
-
-            std::invoke(std::forward<IterationCleanUpCallback>(callback));
-        }
-
-        return std::chrono::duration_cast<DurationType>(duration / n);
-    }
-
-    template <typename DurationType, typename Func, typename... Args>
-    DurationType time_it(Func &&func, Args &&...args)
-        requires std::invocable<Func, Args...> &&
-                 requires { { std::chrono::duration_cast<DurationType>(std::chrono::high_resolution_clock::now() - std::chrono::high_resolution_clock::now()) }; }
-    {
-        return time_it<DurationType>(1, [] {}, std::forward<Func>(func), std::forward<Args>(args)...);
-    }
-}
+#include "exp/time_it.h"
 
 namespace searches
 {
@@ -87,23 +56,19 @@ int main()
     std::sort(vec.begin(), vec.end());
     constexpr auto value = 0;
 
-    const size_t n = 1;
+    const pot::utils::benchmark_options options{.counters = true};
 
-    // auto time_linear = utils::time_it<std::chrono::nanoseconds>(n, [] {}, [&]()
-    //                                                             { volatile auto res = searches::linear_search<int>(vec, value); });
-    // printf("Linear search: %lld ns\n", time_linear.count());
+    // pot::utils::print_result("Linear search", pot::utils::benchmark(options, [&]()
+    //                                                                 { pot::utils::do_not_optimize(searches::linear_search<int>(vec, value)); }));
 
-    auto time_binary_loop = utils::time_it<std::chrono::nanoseconds>(n, [] {}, [&]()
-                                                                     { volatile auto res = searches::binary_search_loop<int>(vec, value); });
-    printf("Binary search loop: %lld ns\n", time_binary_loop.count());
+    pot::utils::print_result("Binary search loop", pot::utils::benchmark(options, [&]()
+                                                                         { pot::utils::do_not_optimize(searches::binary_search_loop<int>(vec, value)); }));
 
-    auto time_binary_recursive = utils::time_it<std::chrono::nanoseconds>(n, [] {}, [&]()
-                                                                          { volatile auto res = searches::binary_search_recursive<int>(vec, value, 0, vec.size() - 1); });
-    printf("Binary search recursive: %lld ns\n", time_binary_recursive.count());
+    pot::utils::print_result("Binary search recursive", pot::utils::benchmark(options, [&]()
+                                                                              { pot::utils::do_not_optimize(searches::binary_search_recursive<int>(vec, value, 0, vec.size() - 1)); }));
 
-    auto time_std_binary = utils::time_it<std::chrono::nanoseconds>(n, [] {}, [&]()
-                                                                    { volatile auto res = std::binary_search(vec.begin(), vec.end(), value); });
-    printf("Std binary search: %lld ns\n", time_std_binary.count());
+    pot::utils::print_result("Std binary search", pot::utils::benchmark(options, [&]()
+                                                                        { pot::utils::do_not_optimize(std::binary_search(vec.begin(), vec.end(), value)); }));
 
     return 0;
 }
\ No newline at end of file